@@ -0,0 +1,185 @@
+#include <benchmark/benchmark.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "cpu_engine.h"
+
+// Benchmarks of one filter step and of the whole comparison, over image size, hwsize, ncol, threads and kernel.
+// pixels_per_second counts the pixels of the image per second, bytes_per_pixel the bytes one call reads and writes
+// per pixel, outside the caches. --benchmark_out=results.json --benchmark_out_format=json keeps the results.
+// A GBF_PERF_COUNTERS build adds the hardware counters of the filter step per pixel, the reads around every
+// row making it slower.
+
+// the pair of the cpu executable scaled to size x size, gray for ncol 1, synthetic when the images are missing
+static void GuidedBilateralBenchImages(int size, int ncol, cv::Mat &orig, cv::Mat &guide)
+{
+	const int flag = ncol == 1 ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR;
+	cv::Mat origimg = cv::imread("../input_images/makale_1.png", flag);
+	cv::Mat guideimg = cv::imread("../input_images/makale_0.png", flag);
+
+	if (origimg.empty() || guideimg.empty())
+	{
+		origimg.create(size, size, CV_8UC(ncol));
+		guideimg.create(size, size, CV_8UC(ncol));
+		cv::randu(origimg, 0, 256);
+		cv::GaussianBlur(origimg, origimg, cv::Size(5, 5), 2.0);
+		cv::add(origimg, cv::Scalar::all(8), guideimg);
+	}
+
+	cv::resize(origimg, orig, cv::Size(size, size));
+	cv::resize(guideimg, guide, cv::Size(size, size));
+}
+
+// skips the runs of kernels the cpu does not have
+static bool GuidedBilateralBenchKernel(benchmark::State &state, int kernel)
+{
+	if (!GuidedBilateralSetKernel((GuidedBilateralKernel)kernel))
+	{
+		state.SkipWithError("kernel not supported by this cpu");
+		return false;
+	}
+	state.SetLabel(GuidedBilateralKernelName((GuidedBilateralKernel)kernel));
+	return true;
+}
+
+static void GuidedBilateralBenchCounters(benchmark::State &state, int pixels, int bytesPerPixel)
+{
+	state.counters["pixels_per_second"] = benchmark::Counter((double)pixels, benchmark::Counter::kIsIterationInvariantRate);
+	state.counters["bytes_per_pixel"] = bytesPerPixel;
+	state.SetBytesProcessed((int64_t)state.iterations() * pixels * bytesPerPixel);
+}
+
+// one GuidedBilateralFilterStep of the final iterations, planar guide
+static void BM_FilterStep(benchmark::State &state)
+{
+	const int size = state.range(0), hwsize = state.range(1), ncol = state.range(2), threads = state.range(3);
+	if (!GuidedBilateralBenchKernel(state, state.range(4)))
+		return;
+	omp_set_num_threads(threads);
+
+	cv::Mat orig, guide;
+	GuidedBilateralBenchImages(size, ncol, orig, guide);
+	std::vector<cv::Mat> origplanes, guideplanes;
+	cv::split(orig, origplanes);
+	cv::split(guide, guideplanes);
+	cv::Mat guideplanar;
+	cv::vconcat(guideplanes, guideplanar);
+
+	const int plane = size * size;
+	std::vector<float> filtered(plane);
+	for (int i = 0; i < plane; i++)
+		filtered[i] = origplanes[0].data[i];
+
+	GuidedBilateralStepCounters counters;
+	counters.Begin("float", true);
+	GuidedBilateralSetStepCounters(&counters);
+	for (auto _ : state)
+	{
+		GuidedBilateralFilterStep(size, size, ncol, origplanes[0].data, guideplanar.data, hwsize, 1.5f, 10.0f, 0.0f, 10.0f, 1.0f, filtered.data());
+		benchmark::DoNotOptimize(filtered.data());
+	}
+	GuidedBilateralSetStepCounters(NULL);
+
+	// filtered in and out, orig and the guide planes
+	GuidedBilateralBenchCounters(state, plane, 2 * sizeof(float) + 1 + ncol);
+	for (int e = 0; e < GBF_COUNTER_EVENTS && counters.active && counters.nsteps > 0; e++)
+		if (counters.events & (1 << e))
+			state.counters[std::string(GuidedBilateralCounterName((GuidedBilateralCounterEvent)e)) + "_per_pixel"] =
+				(double)counters.counts[0][e] / ((double)state.iterations() * plane);
+	GuidedBilateralSetKernel(GuidedBilateralDetectKernel());
+}
+
+// GuidedBilateralFilterCPU::Execute, the whole comparison of a pair
+static void BM_Pipeline(benchmark::State &state)
+{
+	const int size = state.range(0), hwsize = state.range(1), ncol = state.range(2), threads = state.range(3);
+	if (!GuidedBilateralBenchKernel(state, state.range(4)))
+		return;
+
+	cv::Mat orig, guide;
+	GuidedBilateralBenchImages(size, ncol, orig, guide);
+	GuidedBilateralFilterCPU gbFilter(size, size, ncol);
+	gbFilter.hwsize = hwsize;
+	gbFilter.threads = threads;
+
+	for (auto _ : state)
+	{
+		cv::Mat result = gbFilter.Execute(orig, guide);
+		benchmark::DoNotOptimize(result.data);
+	}
+
+	// inputs, IJ and II float planes, IJ, II, difference and mask bytes
+	GuidedBilateralBenchCounters(state, size * size, ncol * (2 + 2 * sizeof(float) + 4));
+	GuidedBilateralSetKernel(GuidedBilateralDetectKernel());
+}
+
+// the pipeline with the warm-up steps on a pyramid level, its psnr and differing mask pixels against the full schedule
+static void BM_PipelinePyramid(benchmark::State &state)
+{
+	const int size = state.range(0), ncol = state.range(1), levels = state.range(2);
+
+	cv::Mat orig, guide;
+	GuidedBilateralBenchImages(size, ncol, orig, guide);
+	GuidedBilateralFilterCPU reference(size, size, ncol);
+	cv::Mat mask = reference.Execute(orig, guide).clone();
+	cv::Mat ij = reference.resultmatIJ.clone(), ii = reference.resultmatII.clone();
+
+	GuidedBilateralFilterCPU gbFilter(size, size, ncol);
+	gbFilter.pyramidLevels = levels;
+	cv::Mat result;
+	for (auto _ : state)
+	{
+		result = gbFilter.Execute(orig, guide);
+		benchmark::DoNotOptimize(result.data);
+	}
+
+	GuidedBilateralBenchCounters(state, size * size, ncol * (2 + 2 * sizeof(float) + 4));
+	state.counters["psnr_ij"] = cv::PSNR(gbFilter.resultmatIJ, ij);
+	state.counters["psnr_ii"] = cv::PSNR(gbFilter.resultmatII, ii);
+	state.counters["mask_differs"] = (double)cv::norm(result, mask, cv::NORM_L1) / (255.0 * mask.total() * mask.channels());
+}
+
+// the pipeline with and without the pre-screen of the tiles, and the share of the pixels it skipped
+static void BM_PipelinePrescreen(benchmark::State &state)
+{
+	const int size = state.range(0), ncol = state.range(1);
+
+	cv::Mat orig, guide;
+	GuidedBilateralBenchImages(size, ncol, orig, guide);
+	GuidedBilateralFilterCPU gbFilter(size, size, ncol);
+	gbFilter.prescreen = state.range(2) != 0;
+
+	for (auto _ : state)
+	{
+		cv::Mat result = gbFilter.Execute(orig, guide);
+		benchmark::DoNotOptimize(result.data);
+	}
+
+	GuidedBilateralBenchCounters(state, size * size, ncol * (2 + 2 * sizeof(float) + 4));
+	state.counters["skipped"] = gbFilter.skipped;
+}
+
+static void GuidedBilateralBenchArgs(benchmark::internal::Benchmark *b, std::vector<int64_t> hwsizes)
+{
+	std::vector<int64_t> threads = {1};
+	if (omp_get_num_procs() > 1)
+		threads.push_back(omp_get_num_procs());
+
+	b->ArgNames({"size", "hwsize", "ncol", "threads", "kernel"});
+	b->ArgsProduct({{256, 512, 1024}, hwsizes, {1, 3}, threads, {GBF_KERNEL_SCALAR, GBF_KERNEL_SSE42, GBF_KERNEL_AVX2, GBF_KERNEL_AVX512}});
+	b->UseRealTime();
+	b->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK(BM_FilterStep)->Apply([](benchmark::internal::Benchmark *b) { GuidedBilateralBenchArgs(b, {1, 2, 3}); });
+BENCHMARK(BM_Pipeline)->Apply([](benchmark::internal::Benchmark *b) { GuidedBilateralBenchArgs(b, {2}); });
+BENCHMARK(BM_PipelinePyramid)->ArgNames({"size", "ncol", "levels"})->ArgsProduct({{256, 512, 1024}, {1, 3}, {0, 1, 2, 3}})->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PipelinePrescreen)->ArgNames({"size", "ncol", "prescreen"})->ArgsProduct({{256, 512, 1024}, {1, 3}, {0, 1}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
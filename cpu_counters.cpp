@@ -0,0 +1,168 @@
+#include "cpu_counters.h"
+
+#include <string.h>
+
+#ifdef GBF_PERF_COUNTERS
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+const char *GuidedBilateralCounterName(GuidedBilateralCounterEvent event)
+{
+	switch (event)
+	{
+	case GBF_COUNTER_CYCLES:
+		return "cycles";
+	case GBF_COUNTER_INSTRUCTIONS:
+		return "instructions";
+	case GBF_COUNTER_LLC_MISSES:
+		return "llc_misses";
+	case GBF_COUNTER_BRANCH_MISSES:
+		return "branch_misses";
+	default:
+		return "unknown";
+	}
+}
+
+#ifdef GBF_PERF_COUNTERS
+
+// The events of a thread, one group read by a single read(): its first opened event leads, the ones that fail to
+// open are left out. Opened on the first read of the thread, closed when the thread exits.
+struct GuidedBilateralCounterGroup
+{
+	int fds[GBF_COUNTER_EVENTS];
+	int leader, events;
+	bool opened;
+
+	GuidedBilateralCounterGroup() : leader(-1), events(0), opened(false)
+	{
+		for (int e = 0; e < GBF_COUNTER_EVENTS; e++)
+			fds[e] = -1;
+	}
+
+	~GuidedBilateralCounterGroup()
+	{
+		for (int e = 0; e < GBF_COUNTER_EVENTS; e++)
+			if (fds[e] >= 0)
+				close(fds[e]);
+	}
+
+	void Open()
+	{
+		static const unsigned long long configs[GBF_COUNTER_EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+																		PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+		opened = true;
+		for (int e = 0; e < GBF_COUNTER_EVENTS; e++)
+		{
+			struct perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = configs[e];
+			attr.read_format = PERF_FORMAT_GROUP;
+			// user space only, allowed by perf_event_paranoid 2
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+
+			// the calling thread on any cpu
+			fds[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+			if (fds[e] < 0)
+				continue;
+			if (leader < 0)
+				leader = fds[e];
+			events |= 1 << e;
+		}
+	}
+};
+
+static thread_local GuidedBilateralCounterGroup counterGroup;
+
+int GuidedBilateralReadCounters(unsigned long long counts[GBF_COUNTER_EVENTS])
+{
+	unsigned long long values[1 + GBF_COUNTER_EVENTS];
+
+	if (!counterGroup.opened)
+		counterGroup.Open();
+	memset(counts, 0, GBF_COUNTER_EVENTS * sizeof(unsigned long long));
+	if (counterGroup.leader < 0 || read(counterGroup.leader, values, sizeof(values)) < (ssize_t)sizeof(values[0]))
+		return (0);
+
+	// values[0] is the count of events, then their values in the order they were opened
+	int v = 1;
+	for (int e = 0; e < GBF_COUNTER_EVENTS && v <= (int)values[0]; e++)
+		if (counterGroup.events & (1 << e))
+			counts[e] = values[v++];
+
+	return counterGroup.events;
+}
+
+int GuidedBilateralCountersAvailable()
+{
+	if (!counterGroup.opened)
+		counterGroup.Open();
+	return counterGroup.events;
+}
+
+#else
+
+int GuidedBilateralReadCounters(unsigned long long counts[GBF_COUNTER_EVENTS])
+{
+	memset(counts, 0, GBF_COUNTER_EVENTS * sizeof(unsigned long long));
+	return (0);
+}
+
+int GuidedBilateralCountersAvailable()
+{
+	return (0);
+}
+
+#endif
+
+void GuidedBilateralStepCounters::Begin(const char *variant_, bool record)
+{
+	kernel = GuidedBilateralKernelName(GuidedBilateralGetKernel());
+	variant = variant_;
+	nsteps = 0;
+	events = record ? GuidedBilateralCountersAvailable() : 0;
+	active = events != 0;
+}
+
+void GuidedBilateralStepCounters::Add(int s, const unsigned long long add[GBF_COUNTER_EVENTS])
+{
+	if (!active || s < 0 || s >= GBF_MAX_STEPS)
+		return;
+	for (; nsteps <= s; nsteps++)
+		memset(counts[nsteps], 0, sizeof(counts[nsteps]));
+	for (int e = 0; e < GBF_COUNTER_EVENTS; e++)
+		counts[s][e] += add[e];
+}
+
+void GuidedBilateralStepCounters::Write(FILE *file, const char *pipeline, long frame) const
+{
+	if (!active || file == NULL)
+		return;
+
+	char line[4096];
+	int n = snprintf(line, sizeof(line), "{\"pipeline\":\"%s\",\"frame\":%ld,\"kernel\":\"%s\",\"variant\":\"%s\",\"steps\":[",
+					 pipeline, frame, kernel, variant);
+	for (int s = 0; s < nsteps && n < (int)sizeof(line); s++)
+	{
+		n += snprintf(line + n, sizeof(line) - n, "%s{", s ? "," : "");
+		const char *separator = "";
+		for (int e = 0; e < GBF_COUNTER_EVENTS && n < (int)sizeof(line); e++)
+		{
+			if (!(events & (1 << e)))
+				continue;
+			n += snprintf(line + n, sizeof(line) - n, "%s\"%s\":%llu", separator, GuidedBilateralCounterName((GuidedBilateralCounterEvent)e), counts[s][e]);
+			separator = ",";
+		}
+		if (n < (int)sizeof(line))
+			n += snprintf(line + n, sizeof(line) - n, "}");
+	}
+	if (n < (int)sizeof(line))
+		snprintf(line + n, sizeof(line) - n, "]}\n");
+	fputs(line, file);
+	fflush(file);
+}
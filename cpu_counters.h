@@ -0,0 +1,46 @@
+#ifndef CPU_COUNTERS_H
+#define CPU_COUNTERS_H
+
+#include <stdio.h>
+
+#include "cpu_filter.h"
+
+// Hardware counters of the filter steps, linux perf_event_open, built with GBF_PERF_COUNTERS.
+// Every thread counts its own user space events, read around each span of rows: the counts of a step are summed
+// over the threads and the tiles, like the step times of timing.h. perf_event_paranoid 2 allows them, the
+// events the cpu or the hypervisor does not expose count 0 and are left out of the json line.
+enum GuidedBilateralCounterEvent
+{
+	GBF_COUNTER_CYCLES = 0,
+	GBF_COUNTER_INSTRUCTIONS,
+	GBF_COUNTER_LLC_MISSES,
+	GBF_COUNTER_BRANCH_MISSES,
+	GBF_COUNTER_EVENTS
+};
+
+const char *GuidedBilateralCounterName(GuidedBilateralCounterEvent event);
+
+// mask of the events the calling thread can count, 0 without GBF_PERF_COUNTERS or perf_event_open
+int GuidedBilateralCountersAvailable();
+
+// reads the events of the calling thread, opened on its first call. returns the mask of the events read.
+int GuidedBilateralReadCounters(unsigned long long counts[GBF_COUNTER_EVENTS]);
+
+// counts of the steps of one frame, per kernel variant
+struct GuidedBilateralStepCounters
+{
+	// simd kernel and filter variant of the frame
+	const char *kernel, *variant;
+	int nsteps = 0, events = 0;
+	bool active = false;
+	unsigned long long counts[GBF_MAX_STEPS][GBF_COUNTER_EVENTS];
+
+	// starts a frame, counted if record and the counters are available
+	void Begin(const char *variant, bool record);
+	// adds the counts of a span of the step s
+	void Add(int s, const unsigned long long counts[GBF_COUNTER_EVENTS]);
+	// one json line: {"pipeline":"cpu","frame":3,"kernel":"avx2","variant":"float","steps":[{"cycles":...},...]}
+	void Write(FILE *file, const char *pipeline, long frame) const;
+};
+
+#endif
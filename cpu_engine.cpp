@@ -0,0 +1,353 @@
+#include "cpu_engine.h"
+
+#include <string.h>
+#include <omp.h>
+
+// absdiff and threshold of the pixels of a tile, run by the filter threads as soon as the tile is done. the filter
+// sees the frame as rows of dimx = cols pixels, a tile row is a run of an image row.
+static void GuidedBilateralCompareTile(void *user, int jbegin, int jend, int ibegin, int iend)
+{
+	GuidedBilateralFilterCPU *engine = (GuidedBilateralFilterCPU *)user;
+	const int nchan = engine->resultmatIJ.channels();
+
+	if (engine->fusedOpening)
+	{
+		GuidedBilateralMaskTile(&engine->maskPass, jbegin, jend, ibegin, iend);
+		return;
+	}
+
+	for (int j = jbegin; j < jend; j++)
+	{
+		cv::Mat ij(1, (iend - ibegin) * nchan, CV_8U, engine->resultmatIJ.ptr(j) + ibegin * nchan);
+		cv::Mat ii(1, (iend - ibegin) * nchan, CV_8U, engine->resultmatII.ptr(j) + ibegin * nchan);
+		cv::Mat diff(1, (iend - ibegin) * nchan, CV_8U, engine->resultmatIIminusIJ.ptr(j) + ibegin * nchan);
+
+		cv::absdiff(ii, ij, diff);
+
+		cv::threshold(diff, diff, engine->threshold, 255, 1);
+	}
+}
+
+// pre-screen of a tile, fills its mask pixels with the threshold result of a comparison under the threshold when the
+// filter can be skipped
+static int GuidedBilateralScreenCompareTile(void *user, int jbegin, int jend, int ibegin, int iend)
+{
+	GuidedBilateralFilterCPU *engine = (GuidedBilateralFilterCPU *)user;
+	const cv::Mat &orig = engine->frameorig, &guide = engine->frameguide;
+	const int nchan = orig.channels();
+
+	if (!GuidedBilateralScreenTile(orig.cols, orig.rows, nchan, orig.data, (int)orig.step, guide.data, (int)guide.step, &engine->tables,
+								   engine->threshold, jbegin, jend, ibegin, iend))
+		return (0);
+
+	if (engine->fusedOpening)
+		GuidedBilateralMaskSkipped(&engine->maskPass, jbegin, jend, ibegin, iend);
+	else
+		for (int j = jbegin; j < jend; j++)
+			memset(engine->resultmatIIminusIJ.ptr(j) + ibegin * nchan, 255, (iend - ibegin) * nchan);
+	engine->skippedPixels.fetch_add((long long)(jend - jbegin) * (iend - ibegin), std::memory_order_relaxed);
+	return (1);
+}
+
+// copy of src spread over the team like the bands of the filter, whose threads then own the pages of their band
+static void GuidedBilateralCopyBands(const cv::Mat &src, cv::Mat &dst)
+{
+	dst.create(src.rows, src.cols, src.type());
+	const size_t rowBytes = src.cols * src.elemSize();
+
+	#pragma omp parallel for schedule(static)
+	for (int r = 0; r < src.rows; r++)
+		memcpy(dst.ptr(r), src.ptr(r), rowBytes);
+}
+
+// true for the 3 x 3 cross of GuidedBilateralMask, the 3 x 3 ellipse
+static bool GuidedBilateralCrossElement(const cv::Mat &element)
+{
+	static const unsigned char cross[9] = {0, 1, 0, 1, 1, 1, 0, 1, 0};
+
+	if (element.rows != 3 || element.cols != 3 || element.type() != CV_8U)
+		return false;
+	for (int i = 0; i < 9; i++)
+		if ((element.ptr(i / 3)[i % 3] != 0) != (cross[i] != 0))
+			return false;
+	return true;
+}
+
+GuidedBilateralFilterCPU::GuidedBilateralFilterCPU(int rows, int cols, int nchan)
+{
+	GuidedBilateralMaskInit(&maskPass);
+	arena = NULL;
+	arenaSize = 0;
+	weights = NULL;
+	weightsSize = 0;
+	pyramid = NULL;
+	pyramidSize = 0;
+	tables.num = 0;
+	Prepare(rows, cols, nchan, CV_8UC(nchan));
+}
+
+GuidedBilateralFilterCPU::~GuidedBilateralFilterCPU()
+{
+	delete[] arena;
+	delete[] weights;
+	delete[] pyramid;
+	GuidedBilateralMaskFree(&maskPass);
+	GuidedBilateralFreeTables(&tables);
+}
+
+void GuidedBilateralFilterCPU::PrepareThreads()
+{
+	// threads 0 keeps the thread count of the caller, OMP_NUM_THREADS or the cpus it may run on
+	const int team = threads > 0 ? threads : omp_get_max_threads();
+
+	if (threads > 0)
+		omp_set_num_threads(threads);
+	if (team != pinnedThreads || affinity != pinnedAffinity)
+	{
+		// NONE only puts back the masks of a team this engine pinned
+		GuidedBilateralPinThreads(affinity, &pinnedMasks);
+		pinnedThreads = team;
+		pinnedAffinity = affinity;
+	}
+	GuidedBilateralSetTileSchedule(bands ? GBF_SCHEDULE_BANDS : GBF_SCHEDULE_DYNAMIC);
+}
+
+int GuidedBilateralFilterCPU::PrepareArena(int nchan, size_t size)
+{
+	const float params[6] = {(float)hwsize, sscale, iscale, ipower, gscale, gpower};
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN)
+		return (0);
+
+	if (tables.num == 0 || memcmp(params, tablesParams, sizeof(params)) != 0)
+	{
+		GuidedBilateralFreeTables(&tables);
+		if (!GuidedBilateralBuildTables(hwsize, sscale, iscale, ipower, gscale, gpower, &tables))
+			return (0);
+		// fails above GBF_FIXED_MAX_DEMISIZE, checked again by the fixed filter
+		GuidedBilateralBuildFixedTables(&tables, &fixedTables);
+		memcpy(tablesParams, params, sizeof(params));
+	}
+
+	if (size > arenaSize)
+	{
+		delete[] arena;
+		arena = new float[size];
+		arenaSize = size;
+	}
+
+	return (1);
+}
+
+int GuidedBilateralFilterCPU::Prepare(int rows, int cols, int nchan, int type)
+{
+	if (!PrepareArena(nchan, 2 * (size_t)nchan * rows * cols))
+		return (0);
+
+	const size_t bytes = GuidedBilateralStaticBytes(cols, rows, nchan, hwsize, staticWeights);
+	if (bytes > weightsSize)
+	{
+		delete[] weights;
+		weights = new unsigned char[bytes];
+		weightsSize = bytes;
+	}
+
+	const size_t levelBytes = GuidedBilateralPyramidBytes(cols, rows, nchan, pyramidLevels);
+	if (levelBytes > pyramidSize)
+	{
+		delete[] pyramid;
+		pyramid = new float[(levelBytes + sizeof(float) - 1) / sizeof(float)];
+		pyramidSize = levelBytes;
+	}
+
+	// no-ops when the size and type did not change
+	resultmatIJ.create(rows, cols, type);
+	resultmatII.create(rows, cols, type);
+	resultmatIIminusIJ.create(rows, cols, type);
+	resultmat.create(rows, cols, type);
+
+	return (1);
+}
+
+cv::Mat GuidedBilateralFilterCPU::Execute(cv::Mat origimg_, cv::Mat guideimg_)
+{
+	// the filter reads guide with the size and type of orig
+	if (guideimg_.rows != origimg_.rows || guideimg_.cols != origimg_.cols || guideimg_.type() != origimg_.type())
+		return cv::Mat();
+
+	timing.Begin();
+	PrepareThreads();
+
+	// the filter reads the interleaved bgr pixels directly, no split / merge of the color channels. the rows are read
+	// through the Mat steps, roi inputs are not copied
+	{
+		GuidedBilateralStage stage(&timing, "copy");
+		if (bands)
+		{
+			GuidedBilateralCopyBands(origimg_, origcopy);
+			GuidedBilateralCopyBands(guideimg_, guidecopy);
+			origimg_ = origcopy;
+			guideimg_ = guidecopy;
+		}
+	}
+
+	{
+		GuidedBilateralStage stage(&timing, "prepare");
+		if (!Prepare(origimg_.rows, origimg_.cols, origimg_.channels(), origimg_.type()))
+			return cv::Mat();
+		// the opening in the filter's threads when the element is the one GuidedBilateralMask implements
+		fusedOpening = GuidedBilateralCrossElement(element) &&
+					   GuidedBilateralMaskBegin(&maskPass, origimg_.cols, origimg_.rows, origimg_.channels(), threshold,
+												resultmatIJ.data, (int)resultmatIJ.step, resultmatII.data, (int)resultmatII.step,
+												resultmatIIminusIJ.data, (int)resultmatIIminusIJ.step, resultmat.data, (int)resultmat.step);
+	}
+
+	// IJ guided by the other image and II guided by orig itself, in one fused pass over orig. the filter stage
+	// includes the absdiff and threshold of the tiles.
+	{
+		static const char *const variants[] = {"float", "static_f32", "static_f16", "static_u8"};
+		GuidedBilateralStage stage(&timing, "filter");
+		counters.Begin(fixedPoint ? "fixed" : pyramidLevels > 0 ? "pyramid" : variants[staticWeights], GuidedBilateralTimingFile().load(std::memory_order_relaxed) != NULL);
+		GuidedBilateralSetStepTiming(&timing);
+		GuidedBilateralSetStepCounters(&counters);
+		int done = 1;
+		skipped = 0.0f;
+		if (fixedPoint)
+		{
+			// the 8.8 planes fit in the float arena
+			done = GuidedBilateralFilterDualFixedScratch(origimg_.cols, origimg_.rows, origimg_.channels(), origimg_.data, (int)origimg_.step, guideimg_.data, (int)guideimg_.step,
+														 &tables, &fixedTables, (unsigned short *)arena, resultmatIJ.data, (int)resultmatIJ.step,
+														 resultmatII.data, (int)resultmatII.step, GuidedBilateralCompareTile, this);
+			iterations = tables.num;
+			meanIterations = (float)tables.num;
+		}
+		else if (pyramidLevels > 0)
+		{
+			done = GuidedBilateralFilterDualPyramid(origimg_.cols, origimg_.rows, origimg_.channels(), origimg_.data, (int)origimg_.step, guideimg_.data, (int)guideimg_.step,
+													&tables, pyramidLevels, arena, pyramid, resultmatIJ.data, (int)resultmatIJ.step,
+													resultmatII.data, (int)resultmatII.step, GuidedBilateralCompareTile, this);
+			iterations = tables.num;
+			meanIterations = (float)tables.num;
+		}
+		else
+		{
+			GuidedBilateralConvergence convergence = {tolerance, maxIterations, tables.num, (float)tables.num};
+			frameorig = origimg_;
+			frameguide = guideimg_;
+			skippedPixels.store(0, std::memory_order_relaxed);
+			done = GuidedBilateralFilterDualScratch(origimg_.cols, origimg_.rows, origimg_.channels(), origimg_.data, (int)origimg_.step, guideimg_.data, (int)guideimg_.step,
+													&tables, arena, resultmatIJ.data, (int)resultmatIJ.step, resultmatII.data, (int)resultmatII.step, (tolerance > 0.0f || maxIterations > 0) ? &convergence : NULL, staticWeights, weights, GuidedBilateralCompareTile, this,
+													prescreen ? GuidedBilateralScreenCompareTile : NULL);
+			iterations = convergence.iterations;
+			meanIterations = convergence.meanIterations;
+			skipped = (float)((double)skippedPixels.load(std::memory_order_relaxed) / ((double)origimg_.rows * origimg_.cols));
+		}
+		GuidedBilateralSetStepTiming(NULL);
+		GuidedBilateralSetStepCounters(NULL);
+		if (!done)
+			return cv::Mat();
+	}
+
+	// absdiff and threshold ran tile by tile in the filter, and the opening block by block with the 3 x 3 cross.
+	// another element needs the whole mask
+	if (!fusedOpening)
+	{
+		GuidedBilateralStage stage(&timing, "opening");
+		morphologyEx(resultmatIIminusIJ, resultmat,
+					 cv::MORPH_OPEN, element,
+					 cv::Point(-1, -1), 2);
+	}
+
+	counters.Write(GuidedBilateralTimingFile().load(std::memory_order_relaxed), "cpu_counters", frame);
+	timing.End("cpu", frame++);
+	return resultmat;
+}
+
+int GuidedBilateralFilterCPU::ExecuteBatch(const std::vector<cv::Mat> &origimgs, const std::vector<cv::Mat> &guideimgs, std::vector<cv::Mat> &results)
+{
+	const int count = (int)origimgs.size();
+
+	results.clear();
+	if (guideimgs.size() != origimgs.size())
+		return (0);
+	if (count == 0)
+		return (1);
+
+	timing.Begin();
+	PrepareThreads();
+
+	// same type for every pair, guides of the size of their image
+	const int type = origimgs[0].type(), nchan = origimgs[0].channels();
+	size_t size = 0;
+	for (int p = 0; p < count; p++)
+	{
+		const cv::Mat &orig = origimgs[p], &guide = guideimgs[p];
+		if (orig.type() != type || guide.type() != type || orig.rows != guide.rows || orig.cols != guide.cols)
+			return (0);
+		size += 2 * (size_t)nchan * orig.rows * orig.cols;
+	}
+
+	{
+		GuidedBilateralStage stage(&timing, "prepare");
+		if (!PrepareArena(nchan, size))
+			return (0);
+
+		batchIJ.resize(count);
+		batchII.resize(count);
+		batchIIminusIJ.resize(count);
+		batchResult.resize(count);
+		batchPairs.resize(count);
+		batchConvergence.resize(count);
+		const bool tracked = tolerance > 0.0f || maxIterations > 0;
+		for (int p = 0; p < count; p++)
+		{
+			const cv::Mat &orig = origimgs[p], &guide = guideimgs[p];
+			batchIJ[p].create(orig.rows, orig.cols, type);
+			batchII[p].create(orig.rows, orig.cols, type);
+			batchIIminusIJ[p].create(orig.rows, orig.cols, type);
+			batchResult[p].create(orig.rows, orig.cols, type);
+
+			GuidedBilateralConvergence convergence = {tolerance, maxIterations, tables.num, (float)tables.num};
+			batchConvergence[p] = convergence;
+			GuidedBilateralPair pair = {orig.cols, orig.rows, orig.data, guide.data, batchIJ[p].data, batchII[p].data, tracked ? &batchConvergence[p] : NULL,
+										(int)orig.step, (int)guide.step, (int)batchIJ[p].step, (int)batchII[p].step};
+			batchPairs[p] = pair;
+		}
+	}
+
+	// the tiles of the pairs mix in one loop, the batch has no per step times
+	{
+		GuidedBilateralStage stage(&timing, "filter");
+		if (!GuidedBilateralFilterDualBatch(count, batchPairs.data(), nchan, &tables, arena))
+			return (0);
+	}
+
+	iterations = 0;
+	meanIterations = 0.0f;
+	for (int p = 0; p < count; p++)
+	{
+		iterations = batchConvergence[p].iterations > iterations ? batchConvergence[p].iterations : iterations;
+		meanIterations += batchConvergence[p].meanIterations / count;
+	}
+
+	// the comparison of every pair, a pair per thread
+	{
+		GuidedBilateralStage stage(&timing, "compare");
+		#pragma omp parallel for schedule(dynamic)
+		for (int p = 0; p < count; p++)
+		{
+			cv::absdiff(batchII[p], batchIJ[p], batchIIminusIJ[p]);
+
+			cv::threshold(batchIIminusIJ[p], batchIIminusIJ[p], threshold, 255, 1);
+
+			morphologyEx(batchIIminusIJ[p], batchResult[p],
+						 cv::MORPH_OPEN, element,
+						 cv::Point(-1, -1), 2);
+		}
+	}
+
+	results = batchResult;
+	timing.End("cpu_batch", frame++);
+
+	return (1);
+}
@@ -0,0 +1,135 @@
+#ifndef CPU_ENGINE_H
+#define CPU_ENGINE_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <atomic>
+#include <vector>
+
+#include "cpu_filter.h"
+#include "cpu_counters.h"
+#include "cpu_mask.h"
+
+// Cpu counterpart of GuidedBilateralFilterGPU, the comparison pipeline of GuidedBilateralFilterToCVImage for a
+// stream of frames. The weight tables, the float planes of the filter and the result images are allocated for
+// the size given to the constructor and reused by every Execute: a stream of frames of that size runs the filter
+// without heap allocation. A larger frame grows the buffers once.
+class GuidedBilateralFilterCPU
+{
+public:
+	// Guided Bilateral Filter parameters, the weight tables are rebuilt when they change
+	int hwsize = 2;
+	float sscale = 1.5f, iscale = 10.0f, ipower = 0.0f, gscale = 10.0f, gpower = 1.0f;
+
+	// Threshold parameter
+	int threshold = 80;
+
+	// Opening parameters
+	int morph_size = 1;
+	cv::Mat element = getStructuringElement(
+		cv::MORPH_ELLIPSE,
+		cv::Size(2 * morph_size + 1,
+				 2 * morph_size + 1),
+		cv::Point(morph_size,
+				  morph_size));
+
+	// 0 for the OpenMP thread count of the calling thread
+	int threads = 0;
+	// numa placement, see GuidedBilateralTileSchedule and GuidedBilateralAffinity. with bands, the inputs are copied
+	// band by band by the threads that filter them so that every thread reads its own node's memory.
+	bool bands = false;
+	GuidedBilateralAffinity affinity = GBF_AFFINITY_NONE;
+	// team the threads were pinned for, and their masks before this engine pinned them
+	int pinnedThreads = 0;
+	GuidedBilateralAffinity pinnedAffinity = GBF_AFFINITY_NONE;
+	GuidedBilateralThreadMasks pinnedMasks;
+
+	// early termination of the final iterations, see GuidedBilateralConvergence. 0 and 0 run the whole schedule.
+	float tolerance = 0.0f;
+	int maxIterations = 0;
+	// steps run by the last Execute, by the slowest row and on average
+	int iterations = 0;
+	float meanIterations = 0.0f;
+
+	// static weight planes of the final iterations, see GuidedBilateralPrecision. trades memory for the guide lookups:
+	// (2 * hwsize + 1)^2 * 2 * nchan values per pixel
+	GuidedBilateralPrecision staticWeights = GBF_STATIC_NONE;
+
+	// 8.8 fixed point filter instead of the float one, see GuidedBilateralFilterDualFixedScratch. runs the whole
+	// schedule, tolerance, maxIterations and staticWeights do not apply.
+	bool fixedPoint = false;
+
+	// warm-up steps on the image reduced by 2^pyramidLevels, see GuidedBilateralFilterDualPyramid. 0 runs them at full
+	// resolution. tolerance, maxIterations and staticWeights do not apply, fixedPoint comes first.
+	int pyramidLevels = 0;
+
+	// pre-screen of the tiles, see GuidedBilateralScreenTile: a tile whose comparison provably stays under the threshold
+	// is not filtered, its mask pixels are set to 255 and resultmatIJ, resultmatII keep their previous bytes there.
+	// the float filter only, fixedPoint and pyramidLevels do not screen.
+	bool prescreen = false;
+	// share of the pixels of the last Execute in skipped tiles
+	float skipped = 0.0f;
+	std::atomic<long long> skippedPixels{0};
+
+	// stage and step times of the last frame, written as a json line when GBF_TIMING is built and an output set,
+	// see timing.h. frame counts the Execute and ExecuteBatch calls.
+	GuidedBilateralTiming timing;
+	long frame = 0;
+	// hardware counters of the steps of the last Execute, written before its timing line with a GBF_PERF_COUNTERS build
+	GuidedBilateralStepCounters counters;
+
+	// arena of the filter, the IJ and II float planes of every channel
+	float *arena;
+	size_t arenaSize;
+	// static weight planes, grown like the arena
+	unsigned char *weights;
+	size_t weightsSize;
+	// coarse level of the pyramid warm-up, float planes first
+	float *pyramid;
+	size_t pyramidSize;
+
+	// tables for the parameters in tablesParams: hwsize, sscale, iscale, ipower, gscale, gpower
+	GuidedBilateralTables tables;
+	GuidedBilateralFixedTables fixedTables;
+	float tablesParams[6];
+
+	// absdiff, threshold and opening of the tiles as the filter finishes them, see GuidedBilateralMask. set by Execute
+	// when element is the 3 x 3 cross, morph_size 1, the opening runs on the whole mask after the filter otherwise.
+	GuidedBilateralMask maskPass;
+	bool fusedOpening = false;
+
+	// copies of the inputs for bands, the inputs of the frame being filtered, filter results and mask
+	cv::Mat origcopy, guidecopy;
+	cv::Mat frameorig, frameguide;
+	cv::Mat resultmatIJ, resultmatII, resultmatIIminusIJ, resultmat;
+
+	// buffers of ExecuteBatch, grown to the largest batch
+	std::vector<cv::Mat> batchIJ, batchII, batchIIminusIJ, batchResult;
+	std::vector<GuidedBilateralPair> batchPairs;
+	std::vector<GuidedBilateralConvergence> batchConvergence;
+
+	// sized for rows x cols images of nchan interleaved channels
+	GuidedBilateralFilterCPU(int rows, int cols, int nchan = 3);
+	GuidedBilateralFilterCPU(const GuidedBilateralFilterCPU &) = delete;
+	GuidedBilateralFilterCPU &operator=(const GuidedBilateralFilterCPU &) = delete;
+	~GuidedBilateralFilterCPU();
+
+	// the returned mask shares the engine's buffer, the next Execute overwrites it. empty when guideimg_ does not have
+	// the size and type of origimg_ or the filter fails
+	cv::Mat Execute(cv::Mat origimg_, cv::Mat guideimg_);
+
+	// the masks of many pairs of images of one type, their tiles filtered in one parallel loop so that small images
+	// keep every core busy. results share the engine's buffers until the next ExecuteBatch. returns 0 on mismatched pairs.
+	int ExecuteBatch(const std::vector<cv::Mat> &origimgs, const std::vector<cv::Mat> &guideimgs, std::vector<cv::Mat> &results);
+
+	// sets the thread count, pinning and tile schedule for the next filter
+	void PrepareThreads();
+
+	// builds the tables if the parameters changed, grows the arena and the images to the frame size
+	int Prepare(int rows, int cols, int nchan, int type);
+	// builds the tables if the parameters changed, grows the arena to size floats
+	int PrepareArena(int nchan, size_t size);
+};
+
+#endif
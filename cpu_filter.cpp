@@ -0,0 +1,1850 @@
+#include "cpu_filter.h"
+#include "cpu_counters.h"
+#include "cpu_weights.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+static GuidedBilateralKernel selectedKernel = GuidedBilateralDetectKernel();
+
+GuidedBilateralKernel GuidedBilateralDetectKernel()
+{
+#ifdef GBF_X86_SIMD
+	// may run from a static initializer, before the runtime filled the cpu model
+	__builtin_cpu_init();
+#endif
+	for (int kernel = GBF_KERNEL_COUNT - 1; kernel > GBF_KERNEL_SCALAR; kernel--)
+		if (GuidedBilateralKernelSupported((GuidedBilateralKernel)kernel))
+			return (GuidedBilateralKernel)kernel;
+	return GBF_KERNEL_SCALAR;
+}
+
+bool GuidedBilateralKernelSupported(GuidedBilateralKernel kernel)
+{
+	switch (kernel)
+	{
+	case GBF_KERNEL_SCALAR:
+		return true;
+#ifdef GBF_X86_SIMD
+	case GBF_KERNEL_SSE42:
+		return __builtin_cpu_supports("sse4.2");
+	case GBF_KERNEL_AVX2:
+		return __builtin_cpu_supports("avx2");
+	case GBF_KERNEL_AVX512:
+		return __builtin_cpu_supports("avx512f");
+#endif
+	default:
+		return false;
+	}
+}
+
+bool GuidedBilateralSetKernel(GuidedBilateralKernel kernel)
+{
+	if (!GuidedBilateralKernelSupported(kernel))
+		return false;
+	selectedKernel = kernel;
+	return true;
+}
+
+GuidedBilateralKernel GuidedBilateralGetKernel()
+{
+	return selectedKernel;
+}
+
+const char *GuidedBilateralKernelName(GuidedBilateralKernel kernel)
+{
+	static const char *names[GBF_KERNEL_COUNT] = {"scalar", "sse4.2", "avx2", "avx512"};
+	return (kernel >= 0 && kernel < GBF_KERNEL_COUNT) ? names[kernel] : "unknown";
+}
+
+static GuidedBilateralRowKernel SelectedRowKernel(int demisize, int ncol)
+{
+	switch (selectedKernel)
+	{
+#ifdef GBF_X86_SIMD
+	case GBF_KERNEL_SSE42:
+		return GuidedBilateralSelectRowSSE42(demisize, ncol);
+	case GBF_KERNEL_AVX2:
+		return GuidedBilateralSelectRowAVX2(demisize, ncol);
+	case GBF_KERNEL_AVX512:
+		return GuidedBilateralSelectRowAVX512(demisize, ncol);
+#endif
+	default:
+		return NULL;
+	}
+}
+
+static GuidedBilateralRowKernel SelectedRowKernelInterleaved(int demisize, int nchan)
+{
+	switch (selectedKernel)
+	{
+#ifdef GBF_X86_SIMD
+	case GBF_KERNEL_SSE42:
+		return GuidedBilateralSelectRowInterleavedSSE42(demisize, nchan);
+	case GBF_KERNEL_AVX2:
+		return GuidedBilateralSelectRowInterleavedAVX2(demisize, nchan);
+	case GBF_KERNEL_AVX512:
+		return GuidedBilateralSelectRowInterleavedAVX512(demisize, nchan);
+#endif
+	default:
+		return NULL;
+	}
+}
+
+static GuidedBilateralDualRowKernel SelectedRowKernelDual(int demisize, int nchan)
+{
+	switch (selectedKernel)
+	{
+#ifdef GBF_X86_SIMD
+	case GBF_KERNEL_SSE42:
+		return GuidedBilateralSelectRowDualSSE42(demisize, nchan);
+	case GBF_KERNEL_AVX2:
+		return GuidedBilateralSelectRowDualAVX2(demisize, nchan);
+	case GBF_KERNEL_AVX512:
+		return GuidedBilateralSelectRowDualAVX512(demisize, nchan);
+#endif
+	default:
+		return NULL;
+	}
+}
+
+static GuidedBilateralDualStaticRowKernel SelectedRowKernelDualStatic(int demisize, int nchan, GuidedBilateralPrecision precision)
+{
+	switch (selectedKernel)
+	{
+#ifdef GBF_X86_SIMD
+	case GBF_KERNEL_SSE42:
+		return GuidedBilateralSelectRowDualStaticSSE42(demisize, nchan, precision);
+	case GBF_KERNEL_AVX2:
+		return GuidedBilateralSelectRowDualStaticAVX2(demisize, nchan, precision);
+	case GBF_KERNEL_AVX512:
+		return GuidedBilateralSelectRowDualStaticAVX512(demisize, nchan, precision);
+#endif
+	default:
+		return NULL;
+	}
+}
+
+static GuidedBilateralDualFixedRowKernel SelectedRowKernelDualFixed(int demisize, int nchan)
+{
+	switch (selectedKernel)
+	{
+#ifdef GBF_X86_SIMD
+	case GBF_KERNEL_SSE42:
+		return GuidedBilateralSelectRowDualFixedSSE42(demisize, nchan);
+	case GBF_KERNEL_AVX2:
+		return GuidedBilateralSelectRowDualFixedAVX2(demisize, nchan);
+	case GBF_KERNEL_AVX512:
+		return GuidedBilateralSelectRowDualFixedAVX512(demisize, nchan);
+#endif
+	default:
+		return NULL;
+	}
+}
+
+// Border = false drops the bounds checks, only for pixels at least demisize away from the image border.
+// Radius and NCol > 0 fix the window radius and the guide channel count at compile time, 0 reads them at runtime.
+template <bool Border, int Radius, int NCol>
+static inline void GuidedBilateralFilterPixel(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+											  float const *swindow, float const *iweight, float const *gweight, float *filtered,
+											  int i, int j)
+{
+	const int r = Radius > 0 ? Radius : demisize;
+	const int nc = NCol > 0 ? NCol : ncol;
+	int value, ediff, currentGuide[3], diffGuide;
+	float wguide, somme, poids, pixelMoy, currentIntensity, diff, rdiff;
+	somme = 1e-6f;
+	pixelMoy = 0.0f;
+	currentIntensity = filtered[j * dimx + i];
+	currentGuide[0] = guide[j * dimx + i];
+	if (nc == 3)
+	{
+		currentGuide[1] = guide[dimx * dimy + j * dimx + i];
+		currentGuide[2] = guide[2 * dimx * dimy + j * dimx + i];
+	}
+
+	for (int k = -r; k <= r; k++)
+	{
+		if (!Border || ((j + k >= 0) && (j + k < dimy)))
+		{
+			float const *sw = swindow + (k + r) * (2 * r + 1) + r;
+			for (int l = -r; l <= r; l++)
+			{
+				if (!Border || ((i + l >= 0) && (i + l < dimx)))
+				{
+					value = orig[(j + k) * dimx + i + l];
+					diff = fabs((float)value - currentIntensity);
+					ediff = (int)diff; // diff >= 0, truncation is the floor
+					rdiff = diff - (float)ediff;
+					diffGuide = abs(guide[(j + k) * dimx + i + l] - currentGuide[0]);
+					wguide = gweight[diffGuide];
+					if (nc == 3)
+					{
+						diffGuide = abs(guide[dimx * dimy + (j + k) * dimx + i + l] - currentGuide[1]);
+						wguide *= gweight[diffGuide];
+						diffGuide = abs(guide[2 * dimx * dimy + (j + k) * dimx + i + l] - currentGuide[2]);
+						wguide *= gweight[diffGuide];
+					}
+					poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * sw[l] * wguide;
+					somme += poids;
+					pixelMoy += poids * (float)value;
+				}
+			}
+		}
+	}
+
+	filtered[j * dimx + i] = pixelMoy / somme;
+}
+
+template <int Radius, int NCol>
+struct GuidedBilateralRowScalar
+{
+	static int run(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+				   float const *swindow, float const *iweight, float const *gweight, float *filtered,
+				   int j, int ibegin, int iend)
+	{
+		for (int i = ibegin; i < iend; i++)
+			GuidedBilateralFilterPixel<false, Radius, NCol>(dimx, dimy, ncol, orig, guide, demisize, swindow, iweight, gweight, filtered, i, j);
+		return iend;
+	}
+};
+
+// The cached weight tables of one step, returns 0 if one cannot be allocated.
+static int GuidedBilateralWeights(int demisize, float sscale, float iscale, float ipower, float gscale, float gpower,
+								  float const **swindow, float const **iweight, float const **gweight)
+{
+	*swindow = GuidedBilateralSpatialWeights(sscale, demisize);
+	*iweight = GuidedBilateralIntensityWeights(iscale, ipower);
+	*gweight = GuidedBilateralGuideWeights(gscale, gpower);
+
+	return *swindow != NULL && *iweight != NULL && *gweight != NULL;
+}
+
+static int tileBytes = GBF_TILE_BYTES;
+
+void GuidedBilateralSetTileBytes(int bytes)
+{
+	tileBytes = bytes > 0 ? bytes : 0;
+}
+
+int GuidedBilateralGetTileBytes()
+{
+	return tileBytes;
+}
+
+static GuidedBilateralTileSchedule tileSchedule = GBF_SCHEDULE_DYNAMIC;
+
+void GuidedBilateralSetTileSchedule(GuidedBilateralTileSchedule schedule)
+{
+	tileSchedule = schedule;
+}
+
+GuidedBilateralTileSchedule GuidedBilateralGetTileSchedule()
+{
+	return tileSchedule;
+}
+
+static thread_local GuidedBilateralTiming *stepTiming = NULL;
+static thread_local GuidedBilateralStepCounters *stepCounters = NULL;
+
+void GuidedBilateralSetStepTiming(GuidedBilateralTiming *timing)
+{
+	stepTiming = timing;
+}
+
+void GuidedBilateralSetStepCounters(GuidedBilateralStepCounters *counters)
+{
+	stepCounters = counters;
+}
+
+int GuidedBilateralPinThreads(GuidedBilateralAffinity affinity, GuidedBilateralThreadMasks *threadMasks)
+{
+	int pinned = 0;
+#if defined(__linux__) && defined(_OPENMP)
+	// NONE puts back the masks saved by an earlier pinning, leaves the threads alone otherwise
+	bool any = false;
+	for (size_t t = 0; t < threadMasks->saved.size(); t++)
+		any = any || threadMasks->saved[t];
+	if (affinity == GBF_AFFINITY_NONE && !any)
+		return (0);
+
+	const int team = omp_get_max_threads();
+	if ((int)threadMasks->saved.size() < team)
+	{
+		threadMasks->masks.resize(team * sizeof(cpu_set_t));
+		threadMasks->saved.resize(team, 0);
+	}
+	cpu_set_t *masks = (cpu_set_t *)threadMasks->masks.data();
+	unsigned char *saved = threadMasks->saved.data();
+	cpu_set_t allowed;
+	int ncpus = 0, cpus[CPU_SETSIZE];
+	CPU_ZERO(&allowed);
+
+	#pragma omp parallel reduction(+ : pinned)
+	{
+		const int t = omp_get_thread_num(), n = omp_get_num_threads();
+		if (affinity == GBF_AFFINITY_NONE)
+		{
+			if (t < team && saved[t])
+				sched_setaffinity(0, sizeof(cpu_set_t), &masks[t]);
+		}
+		else
+		{
+			// the mask of each thread before its first pinning, under OMP_PROC_BIND the place of the thread. the
+			// threads are spread over the union of these masks
+			if (t < team && !saved[t] && sched_getaffinity(0, sizeof(cpu_set_t), &masks[t]) == 0)
+				saved[t] = 1;
+			#pragma omp critical
+			if (t < team && saved[t])
+				CPU_OR(&allowed, &allowed, &masks[t]);
+			#pragma omp barrier
+			#pragma omp single
+			for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+				if (CPU_ISSET(cpu, &allowed))
+					cpus[ncpus++] = cpu;
+			// a thread whose mask could not be read is not pinned, NONE could not put it back
+			if (ncpus > 0 && t < team && saved[t])
+			{
+				cpu_set_t set;
+				CPU_ZERO(&set);
+				CPU_SET(affinity == GBF_AFFINITY_CLOSE ? cpus[t % ncpus] : cpus[(int)((long long)t * ncpus / n) % ncpus], &set);
+				pinned += sched_setaffinity(0, sizeof(set), &set) == 0;
+			}
+		}
+	}
+	if (affinity == GBF_AFFINITY_NONE)
+		threadMasks->saved.assign(threadMasks->saved.size(), 0);
+#endif
+	return pinned;
+}
+
+void GuidedBilateralFreeTables(GuidedBilateralTables *tables)
+{
+	// the cache keeps the tables
+	tables->num = 0;
+}
+
+// the final iterations are the trailing steps with the parameters of the last one, returns the first
+static int GuidedBilateralFinalSteps(GuidedBilateralStepParams const *steps, int num)
+{
+	int gnc = num - 1;
+	while (gnc > 0 && memcmp(&steps[gnc - 1], &steps[num - 1], sizeof(GuidedBilateralStepParams)) == 0)
+		gnc--;
+	return gnc;
+}
+
+int GuidedBilateralBuildTables(int demisize, float sscale, float iscale, float ipower, float gscale, float gpower, GuidedBilateralTables *tables)
+{
+	GuidedBilateralStepParams steps[GBF_MAX_STEPS];
+	int num = GuidedBilateralSchedule(sscale, iscale, ipower, gscale, gpower, steps);
+
+	tables->demisize = demisize;
+	tables->gnc = GuidedBilateralFinalSteps(steps, num);
+
+	for (tables->num = 0; tables->num < num; tables->num++)
+	{
+		const GuidedBilateralStepParams &p = steps[tables->num];
+		if (!GuidedBilateralWeights(demisize, p.sscale, p.iscale, p.ipower, p.gscale, p.gpower,
+									&tables->swindow[tables->num], &tables->iweight[tables->num], &tables->gweight[tables->num]))
+		{
+			GuidedBilateralFreeTables(tables);
+			return (0);
+		}
+		tables->steps[tables->num] = p;
+	}
+
+	return (1);
+}
+
+int GuidedBilateralBuildPolicyTables(GuidedBilateralPolicy policy, int demisize, float sscale, float iscale, float ipower, float gscale, float gpower,
+									 GuidedBilateralTables *tables)
+{
+	GuidedBilateralStepParams steps[GBF_MAX_STEPS];
+	int num = 1;
+
+	switch (policy)
+	{
+	case GBF_POLICY_GUIDED:
+		return GuidedBilateralBuildTables(demisize, sscale, iscale, ipower, gscale, gpower, tables);
+	case GBF_POLICY_ROBUST:
+		num = GuidedBilateralSchedule(sscale, iscale, ipower, 0.0f, 0.0f, steps);
+		break;
+	case GBF_POLICY_BILATERAL:
+		steps[0] = {sscale, iscale, 0.0f, 0.0f, 0.0f};
+		break;
+	case GBF_POLICY_JOINTCROSS:
+		steps[0] = {sscale, 0.0f, 0.0f, gscale, 0.0f};
+		break;
+	default:
+		return (0);
+	}
+
+	tables->demisize = demisize;
+	tables->gnc = GuidedBilateralFinalSteps(steps, num);
+
+	for (tables->num = 0; tables->num < num; tables->num++)
+	{
+		const GuidedBilateralStepParams &p = steps[tables->num];
+		const int s = tables->num;
+		tables->swindow[s] = GuidedBilateralSpatialWeights(p.sscale, demisize);
+		switch (policy)
+		{
+		case GBF_POLICY_ROBUST:
+			tables->iweight[s] = GuidedBilateralIntensityWeights(p.iscale, p.ipower);
+			tables->gweight[s] = GuidedBilateralUnitWeights();
+			break;
+		case GBF_POLICY_BILATERAL:
+			tables->iweight[s] = GuidedBilateralGaussianWeights(p.iscale);
+			tables->gweight[s] = GuidedBilateralConstantWeights(GBF_POLICY_SUM_SCALE);
+			break;
+		default:
+			tables->iweight[s] = GuidedBilateralUnitWeights();
+			tables->gweight[s] = GuidedBilateralGaussianWeights(p.gscale);
+			break;
+		}
+		if (tables->swindow[s] == NULL || tables->iweight[s] == NULL || tables->gweight[s] == NULL)
+		{
+			GuidedBilateralFreeTables(tables);
+			return (0);
+		}
+		tables->steps[s] = p;
+	}
+
+	return (1);
+}
+
+const char *GuidedBilateralPolicyName(GuidedBilateralPolicy policy)
+{
+	static const char *names[GBF_POLICY_JOINTCROSS + 1] = {"guided", "robust", "bilateral", "jointcross"};
+	return (policy >= 0 && policy <= GBF_POLICY_JOINTCROSS) ? names[policy] : "unknown";
+}
+
+// Early termination state of GuidedBilateralRunSteps: the nplanes float planes of filtered, dimx * dimy apart,
+// are compared before and after every final iteration of a segment
+struct GuidedBilateralTrack
+{
+	float *filtered;
+	int nplanes, gnc;
+	GuidedBilateralConvergence *convergence;
+};
+
+// Runs span(s, j, ibegin, iend) on a segment of at most GBF_TRACK_SEGMENT pixels, returns the largest change of
+// a pixel of the track planes
+template <class Span>
+static float GuidedBilateralTrackSpan(const GuidedBilateralTrack *track, int dimx, int dimy, Span &span, int s, int j, int ibegin, int iend)
+{
+	float old[GBF_TRACK_SEGMENT * 2 * GBF_MAX_NCHAN], change = 0.0f;
+	const int plane = dimx * dimy, n = iend - ibegin;
+
+	for (int p = 0; p < track->nplanes; p++)
+		memcpy(old + p * n, track->filtered + p * plane + j * dimx + ibegin, n * sizeof(float));
+	span(s, j, ibegin, iend);
+	for (int p = 0; p < track->nplanes; p++)
+	{
+		float const *row = track->filtered + p * plane + j * dimx + ibegin;
+		for (int i = 0; i < n; i++)
+		{
+			float diff = fabs(row[i] - old[p * n + i]);
+			if (diff > change)
+				change = diff;
+		}
+	}
+
+	return change;
+}
+
+// Tile cut of an image for GuidedBilateralRunSteps: whole rows if GBF_TILE_MIN_ROWS of them fit, columns cut in
+// multiples of 64 pixels otherwise, and bands thin enough to give every thread a few tiles when the image is alone
+struct GuidedBilateralTiling
+{
+	int dimx, dimy, tilex, tiley, ntilex, ntiley;
+};
+
+static GuidedBilateralTiling GuidedBilateralTiles(int dimx, int dimy, int pixbytes, bool tracked, bool balance)
+{
+	const int budget = tileBytes > 0 ? tileBytes : GBF_TILE_BYTES;
+	int tilex = dimx, tiley = budget / (dimx * pixbytes);
+	if (tiley < GBF_TILE_MIN_ROWS)
+	{
+		tiley = GBF_TILE_MIN_ROWS;
+		tilex = budget / (tiley * pixbytes) / 64 * 64;
+		if (tilex < 64)
+			tilex = 64;
+	}
+	if (tiley > GBF_TILE_MAX_ROWS)
+		tiley = GBF_TILE_MAX_ROWS;
+	if (tracked)
+	{
+		// the active list of a tile holds at most GBF_TRACK_MAX_SEGMENTS segments
+		tilex = tilex < GBF_TRACK_MAX_SEGMENTS * GBF_TRACK_SEGMENT ? tilex : GBF_TRACK_MAX_SEGMENTS * GBF_TRACK_SEGMENT;
+		const int segments = (tilex + GBF_TRACK_SEGMENT - 1) / GBF_TRACK_SEGMENT;
+		if (tiley * segments > GBF_TRACK_MAX_SEGMENTS)
+			tiley = GBF_TRACK_MAX_SEGMENTS / segments;
+	}
+#ifdef _OPENMP
+	const int bands = dimy / (4 * omp_get_max_threads());
+	if (balance && tilex == dimx && tiley > bands)
+		tiley = bands > 1 ? bands : 1;
+#endif
+
+	GuidedBilateralTiling tiling = {dimx, dimy, tilex, tiley, (dimx + tilex - 1) / tilex, (dimy + tiley - 1) / tiley};
+	return tiling;
+}
+
+// Runs the num steps on the tile t. A step only reads filtered at the pixel it writes, so the steps of a pixel do not
+// depend on its neighbors': the tile goes through all the steps while it is in cache, without halo.
+// With a track, the tile keeps a compact list of its active row segments through the final iterations and drops
+// the ones that changed by less than the tolerance. The segments are aligned on the image, not on the tile, so the
+// result does not depend on the tile cut nor on the thread count. iterations and pixelSteps accumulate the steps run.
+template <class Span>
+static void GuidedBilateralRunTile(const GuidedBilateralTiling &tiling, int t, int num, Span &span, const GuidedBilateralTrack *track,
+								   int &iterations, double &pixelSteps)
+{
+	const int dimx = tiling.dimx, dimy = tiling.dimy;
+	const int i0 = (t % tiling.ntilex) * tiling.tilex, j0 = (t / tiling.ntilex) * tiling.tiley;
+	const int i1 = i0 + tiling.tilex < dimx ? i0 + tiling.tilex : dimx, j1 = j0 + tiling.tiley < dimy ? j0 + tiling.tiley : dimy;
+
+	if (track == NULL)
+	{
+		for (int s = 0; s < num; s++)
+			for (int j = j0; j < j1; j++)
+				span(s, j, i0, i1);
+		return;
+	}
+
+	GuidedBilateralConvergence *convergence = track->convergence;
+	int finals = num - track->gnc;
+	if (convergence->maxIterations > 0 && convergence->maxIterations < finals)
+		finals = convergence->maxIterations;
+	// segment starts as j * dimx + i
+	int active[GBF_TRACK_MAX_SEGMENTS], nactive = 0;
+
+	for (int s = 0; s < track->gnc; s++)
+		for (int j = j0; j < j1; j++)
+			span(s, j, i0, i1);
+	pixelSteps += (double)track->gnc * (i1 - i0) * (j1 - j0);
+
+	for (int j = j0; j < j1; j++)
+		for (int i = i0; i < i1; i += GBF_TRACK_SEGMENT)
+			active[nactive++] = j * dimx + i;
+
+	for (int f = 0; f < finals && nactive > 0; f++)
+	{
+		int kept = 0;
+		for (int a = 0; a < nactive; a++)
+		{
+			const int j = active[a] / dimx, i = active[a] % dimx;
+			const int iend = i + GBF_TRACK_SEGMENT < i1 ? i + GBF_TRACK_SEGMENT : i1;
+			if (GuidedBilateralTrackSpan(track, dimx, dimy, span, track->gnc + f, j, i, iend) >= convergence->tolerance)
+				active[kept++] = active[a];
+			pixelSteps += iend - i;
+		}
+		if (track->gnc + f + 1 > iterations)
+			iterations = track->gnc + f + 1;
+		nactive = kept;
+	}
+}
+
+// Runs span(s, j, ibegin, iend) for the num steps over the image, pixbytes being the bytes read and written per pixel,
+// one GuidedBilateralRunTile per tile. done(jbegin, jend, ibegin, iend) follows every tile, or every row without
+// tiling, in the thread that ran it: the whole frame is one parallel loop, with no serial pass nor join per step.
+// A tile skip(user, ...) returns 1 for runs neither its steps nor done, skip needs the tiles.
+template <class Span, class Done>
+static void GuidedBilateralRunStepsLoop(int dimx, int dimy, int num, int pixbytes, Span span, const GuidedBilateralTrack *track, Done done,
+										GuidedBilateralSkipCallback skip, void *user)
+{
+	// a single step has nothing to keep in cache for the next one, its rows need no tiles
+	if ((tileBytes == 0 || num == 1) && track == NULL && skip == NULL)
+	{
+		for (int s = 0; s < num; s++)
+		{
+			#pragma omp parallel for schedule(static)
+			for (int j = 0; j < dimy; j++)
+				span(s, j, 0, dimx);
+		}
+		#pragma omp parallel for schedule(static)
+		for (int j = 0; j < dimy; j++)
+			done(j, j + 1, 0, dimx);
+		return;
+	}
+
+	GuidedBilateralTiling tiling = GuidedBilateralTiles(dimx, dimy, pixbytes, track != NULL, true);
+	if (skip != NULL)
+	{
+		// small square tiles, the pre-screen of a large one rarely passes
+		tiling.tilex = tiling.tilex < GBF_SCREEN_TILE ? tiling.tilex : GBF_SCREEN_TILE;
+		tiling.tiley = tiling.tiley < GBF_SCREEN_TILE ? tiling.tiley : GBF_SCREEN_TILE;
+		tiling.ntilex = (dimx + tiling.tilex - 1) / tiling.tilex;
+		tiling.ntiley = (dimy + tiling.tiley - 1) / tiling.tiley;
+	}
+	const int ntiles = tiling.ntilex * tiling.ntiley;
+	int iterations = track ? track->gnc : 0;
+	double pixelSteps = 0.0;
+	auto tile = [&](int t, int &iterations, double &pixelSteps)
+	{
+		const int i0 = (t % tiling.ntilex) * tiling.tilex, j0 = (t / tiling.ntilex) * tiling.tiley;
+		const int i1 = i0 + tiling.tilex < dimx ? i0 + tiling.tilex : dimx, j1 = j0 + tiling.tiley < dimy ? j0 + tiling.tiley : dimy;
+		if (skip && skip(user, j0, j1, i0, i1))
+			return;
+		GuidedBilateralRunTile(tiling, t, num, span, track, iterations, pixelSteps);
+		done(j0, j1, i0, i1);
+	};
+
+	// the tiles are in row order, a static split gives every thread a band of rows
+	if (tileSchedule == GBF_SCHEDULE_BANDS)
+	{
+		#pragma omp parallel for schedule(static) reduction(max : iterations) reduction(+ : pixelSteps)
+		for (int t = 0; t < ntiles; t++)
+			tile(t, iterations, pixelSteps);
+	}
+	else
+	{
+		#pragma omp parallel for schedule(dynamic) reduction(max : iterations) reduction(+ : pixelSteps)
+		for (int t = 0; t < ntiles; t++)
+			tile(t, iterations, pixelSteps);
+	}
+
+	if (track != NULL)
+	{
+		track->convergence->iterations = iterations;
+		track->convergence->meanIterations = (float)(pixelSteps / ((double)dimx * dimy));
+	}
+}
+
+// step times and counts of a thread, kept apart from the other threads' lines
+struct alignas(64) GuidedBilateralStepProbe
+{
+	double ms[GBF_MAX_STEPS];
+	unsigned long long counts[GBF_MAX_STEPS][GBF_COUNTER_EVENTS];
+};
+
+// GuidedBilateralRunStepsLoop, with the spans timed and counted per step when the calling thread set a recording
+// step timing or step counters
+template <class Span, class Done>
+static void GuidedBilateralRunSteps(int dimx, int dimy, int num, int pixbytes, Span span, const GuidedBilateralTrack *track, Done done,
+									GuidedBilateralSkipCallback skip = NULL, void *user = NULL)
+{
+#if defined(GBF_TIMING) || defined(GBF_PERF_COUNTERS)
+	GuidedBilateralTiming *timing = stepTiming != NULL && stepTiming->active ? stepTiming : NULL;
+	GuidedBilateralStepCounters *counters = stepCounters != NULL && stepCounters->active ? stepCounters : NULL;
+	if (timing != NULL || counters != NULL)
+	{
+		const int nthreads = omp_get_max_threads();
+		GuidedBilateralStepProbe *probes = new GuidedBilateralStepProbe[nthreads]();
+		GuidedBilateralRunStepsLoop(dimx, dimy, num, pixbytes, [&](int s, int j, int ibegin, int iend)
+		{
+			GuidedBilateralStepProbe &probe = probes[omp_get_thread_num()];
+			unsigned long long before[GBF_COUNTER_EVENTS], after[GBF_COUNTER_EVENTS];
+			if (counters != NULL)
+				GuidedBilateralReadCounters(before);
+			const double start = timing != NULL ? GuidedBilateralTiming::Now() : 0.0;
+			span(s, j, ibegin, iend);
+			if (timing != NULL)
+				probe.ms[s] += GuidedBilateralTiming::Now() - start;
+			if (counters != NULL)
+			{
+				GuidedBilateralReadCounters(after);
+				for (int e = 0; e < GBF_COUNTER_EVENTS; e++)
+					probe.counts[s][e] += after[e] - before[e];
+			}
+		}, track, done, skip, user);
+		for (int t = 0; t < nthreads; t++)
+			for (int s = 0; s < num; s++)
+			{
+				if (timing != NULL)
+					timing->Step(s, probes[t].ms[s]);
+				if (counters != NULL)
+					counters->Add(s, probes[t].counts[s]);
+			}
+		delete[] probes;
+		return;
+	}
+#endif
+	GuidedBilateralRunStepsLoop(dimx, dimy, num, pixbytes, span, track, done, skip, user);
+}
+
+template <class Span>
+static void GuidedBilateralRunSteps(int dimx, int dimy, int num, int pixbytes, Span span, const GuidedBilateralTrack *track = NULL)
+{
+	GuidedBilateralRunSteps(dimx, dimy, num, pixbytes, span, track, [](int, int, int, int) {});
+}
+
+// Filters the pixels [ibegin, iend) of the row j: the ones closer than demisize to the border go through the
+// bounds checked loop, the interior through the simd kernel and the unchecked loop specialized for demisize
+// and ncol. all compute the same operations in the same order, the result does not depend on the path.
+static void GuidedBilateralFilterSpan(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+									  float const *swindow, float const *iweight, float const *gweight, float *filtered,
+									  GuidedBilateralRowKernel simdRow, GuidedBilateralRowKernel scalarRow, int j, int ibegin, int iend)
+{
+	int i = ibegin;
+	if (j >= demisize && j < dimy - demisize && dimx > 2 * demisize)
+	{
+		const int inner = iend < dimx - demisize ? iend : dimx - demisize;
+		for (; i < demisize && i < iend; i++)
+			GuidedBilateralFilterPixel<true, 0, 0>(dimx, dimy, ncol, orig, guide, demisize, swindow, iweight, gweight, filtered, i, j);
+		if (simdRow && i < inner)
+			i = simdRow(dimx, dimy, ncol, orig, guide, demisize, swindow, iweight, gweight, filtered, j, i, inner);
+		if (i < inner)
+			i = scalarRow(dimx, dimy, ncol, orig, guide, demisize, swindow, iweight, gweight, filtered, j, i, inner);
+	}
+	for (; i < iend; i++)
+		GuidedBilateralFilterPixel<true, 0, 0>(dimx, dimy, ncol, orig, guide, demisize, swindow, iweight, gweight, filtered, i, j);
+}
+
+int GuidedBilateralFilterStep(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+							  float sscale, float iscale, float ipower, float gscale, float gpower, float *filtered)
+{
+	float const *swindow, *iweight, *gweight;
+
+	if (!GuidedBilateralWeights(demisize, sscale, iscale, ipower, gscale, gpower, &swindow, &iweight, &gweight))
+		return (0);
+
+	GuidedBilateralRowKernel simdRow = SelectedRowKernel(demisize, ncol);
+	GuidedBilateralRowKernel scalarRow = GuidedBilateralSelectRow<GuidedBilateralRowScalar>(demisize, ncol);
+
+	GuidedBilateralRunSteps(dimx, dimy, 1, sizeof(float) + 1 + ncol, [&](int, int j, int ibegin, int iend)
+	{
+		GuidedBilateralFilterSpan(dimx, dimy, ncol, orig, guide, demisize, swindow, iweight, gweight, filtered, simdRow, scalarRow, j, ibegin, iend);
+	});
+
+	return (1);
+}
+
+int GuidedBilateralSchedule(float sscale, float iscale, float ipower, float gscale, float gpower, GuidedBilateralStepParams *steps)
+{
+	int n = 0, num = GBF_MAX_STEPS;
+
+	/* GNC */
+	if (ipower <= 1.0f)
+	{
+		steps[n++] = {0.0f, iscale, 1.0f, gscale * 5.0f, gpower};
+		num--;
+	}
+
+	if (ipower <= 0.5f)
+	{
+		steps[n++] = {sscale, iscale, 0.5f, gscale, gpower};
+		num--;
+	}
+
+	if (ipower <= 0.0f)
+	{
+		steps[n++] = {sscale, iscale, 0.0f, gscale, gpower};
+		num--;
+	}
+
+	/* final */
+	for (int i = 0; i < num; i++)
+		steps[n++] = {sscale, iscale, ipower, gscale, gpower};
+
+	return n;
+}
+
+int GuidedBilateralFilter(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize, float sscale, float iscale, float ipower, float gscale, float gpower, unsigned char *result)
+{
+	GuidedBilateralTables tables;
+
+	if (!GuidedBilateralBuildTables(demisize, sscale, iscale, ipower, gscale, gpower, &tables))
+		return (0);
+
+	const int ok = GuidedBilateralFilterTables(dimx, dimy, ncol, orig, guide, &tables, result);
+	GuidedBilateralFreeTables(&tables);
+
+	return ok;
+}
+
+int GuidedBilateralFilterTables(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide,
+								GuidedBilateralTables const *tables, unsigned char *result)
+{
+	const int demisize = tables->demisize;
+
+	GuidedBilateralRowKernel simdRow = SelectedRowKernel(demisize, ncol);
+	GuidedBilateralRowKernel scalarRow = GuidedBilateralSelectRow<GuidedBilateralRowScalar>(demisize, ncol);
+
+	/* alloc */
+	float *filtered = new float[dimx * dimy];
+
+	/* init image */
+	for (int i = 0; i < dimx * dimy; i++)
+		filtered[i] = (float)(orig[i]);
+
+	/* GNC and final iterations */
+	GuidedBilateralRunSteps(dimx, dimy, tables->num, sizeof(float) + 1 + ncol, [&](int s, int j, int ibegin, int iend)
+	{
+		GuidedBilateralFilterSpan(dimx, dimy, ncol, orig, guide, demisize, tables->swindow[s], tables->iweight[s], tables->gweight[s], filtered,
+								  simdRow, scalarRow, j, ibegin, iend);
+	});
+
+	for (int i = 0; i < dimx * dimy; i++)
+		result[i] = (unsigned char)(filtered[i]);
+
+	delete[] filtered;
+
+	return (1);
+}
+
+// Border = false drops the bounds checks, only for pixels at least demisize away from the image border.
+// Radius and NChan > 0 fix the window radius and the channel count at compile time, 0 reads them at runtime.
+// Every channel runs the operations of GuidedBilateralFilterPixel with ncol = 1, in the same order.
+template <bool Border, int Radius, int NChan>
+static inline void GuidedBilateralFilterPixelInterleaved(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+														 float const *swindow, float const *iweight, float const *gweight, float *filtered,
+														 int i, int j)
+{
+	const int r = Radius > 0 ? Radius : demisize;
+	const int nc = NChan > 0 ? NChan : nchan;
+	const int plane = dimx * dimy;
+	int value, ediff, currentGuide[GBF_MAX_NCHAN], diffGuide;
+	float wguide, somme[GBF_MAX_NCHAN], poids, pixelMoy[GBF_MAX_NCHAN], currentIntensity[GBF_MAX_NCHAN], diff, rdiff;
+	for (int c = 0; c < nc; c++)
+	{
+		somme[c] = 1e-6f;
+		pixelMoy[c] = 0.0f;
+		currentIntensity[c] = filtered[c * plane + j * dimx + i];
+		currentGuide[c] = guide[(j * dimx + i) * nc + c];
+	}
+
+	for (int k = -r; k <= r; k++)
+	{
+		if (!Border || ((j + k >= 0) && (j + k < dimy)))
+		{
+			float const *sw = swindow + (k + r) * (2 * r + 1) + r;
+			for (int l = -r; l <= r; l++)
+			{
+				if (!Border || ((i + l >= 0) && (i + l < dimx)))
+				{
+					const int pixel = ((j + k) * dimx + i + l) * nc;
+					for (int c = 0; c < nc; c++)
+					{
+						value = orig[pixel + c];
+						diff = fabs((float)value - currentIntensity[c]);
+						ediff = (int)diff; // diff >= 0, truncation is the floor
+						rdiff = diff - (float)ediff;
+						diffGuide = abs(guide[pixel + c] - currentGuide[c]);
+						wguide = gweight[diffGuide];
+						poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * sw[l] * wguide;
+						somme[c] += poids;
+						pixelMoy[c] += poids * (float)value;
+					}
+				}
+			}
+		}
+	}
+
+	for (int c = 0; c < nc; c++)
+		filtered[c * plane + j * dimx + i] = pixelMoy[c] / somme[c];
+}
+
+template <int Radius, int NChan>
+struct GuidedBilateralRowScalarInterleaved
+{
+	static int run(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+				   float const *swindow, float const *iweight, float const *gweight, float *filtered,
+				   int j, int ibegin, int iend)
+	{
+		for (int i = ibegin; i < iend; i++)
+			GuidedBilateralFilterPixelInterleaved<false, Radius, NChan>(dimx, dimy, nchan, orig, guide, demisize, swindow, iweight, gweight, filtered, i, j);
+		return iend;
+	}
+};
+
+// same split as GuidedBilateralFilterSpan, the simd kernel stops two pixels before the end of the row
+static void GuidedBilateralFilterSpanInterleaved(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+												 float const *swindow, float const *iweight, float const *gweight, float *filtered,
+												 GuidedBilateralRowKernel simdRow, GuidedBilateralRowKernel scalarRow, int j, int ibegin, int iend)
+{
+	int i = ibegin;
+	if (j >= demisize && j < dimy - demisize && dimx > 2 * demisize)
+	{
+		const int inner = iend < dimx - demisize ? iend : dimx - demisize;
+		const int simdEnd = iend < dimx - demisize - 2 ? iend : dimx - demisize - 2;
+		for (; i < demisize && i < iend; i++)
+			GuidedBilateralFilterPixelInterleaved<true, 0, 0>(dimx, dimy, nchan, orig, guide, demisize, swindow, iweight, gweight, filtered, i, j);
+		if (simdRow && i < simdEnd)
+			i = simdRow(dimx, dimy, nchan, orig, guide, demisize, swindow, iweight, gweight, filtered, j, i, simdEnd);
+		if (i < inner)
+			i = scalarRow(dimx, dimy, nchan, orig, guide, demisize, swindow, iweight, gweight, filtered, j, i, inner);
+	}
+	for (; i < iend; i++)
+		GuidedBilateralFilterPixelInterleaved<true, 0, 0>(dimx, dimy, nchan, orig, guide, demisize, swindow, iweight, gweight, filtered, i, j);
+}
+
+int GuidedBilateralFilterStepInterleaved(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+										 float sscale, float iscale, float ipower, float gscale, float gpower, float *filtered)
+{
+	float const *swindow, *iweight, *gweight;
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN)
+		return (0);
+	if (!GuidedBilateralWeights(demisize, sscale, iscale, ipower, gscale, gpower, &swindow, &iweight, &gweight))
+		return (0);
+
+	GuidedBilateralRowKernel simdRow = SelectedRowKernelInterleaved(demisize, nchan);
+	GuidedBilateralRowKernel scalarRow = GuidedBilateralSelectRow<GuidedBilateralRowScalarInterleaved>(demisize, nchan);
+
+	GuidedBilateralRunSteps(dimx, dimy, 1, nchan * (sizeof(float) + 2), [&](int, int j, int ibegin, int iend)
+	{
+		GuidedBilateralFilterSpanInterleaved(dimx, dimy, nchan, orig, guide, demisize, swindow, iweight, gweight, filtered, simdRow, scalarRow, j, ibegin, iend);
+	});
+
+	return (1);
+}
+
+int GuidedBilateralFilterInterleaved(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+									 float sscale, float iscale, float ipower, float gscale, float gpower, unsigned char *result)
+{
+	GuidedBilateralTables tables;
+
+	if (!GuidedBilateralBuildTables(demisize, sscale, iscale, ipower, gscale, gpower, &tables))
+		return (0);
+
+	const int ok = GuidedBilateralFilterInterleavedTables(dimx, dimy, nchan, orig, guide, &tables, result);
+	GuidedBilateralFreeTables(&tables);
+
+	return ok;
+}
+
+int GuidedBilateralFilterInterleavedTables(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide,
+										   GuidedBilateralTables const *tables, unsigned char *result)
+{
+	const int plane = dimx * dimy, demisize = tables->demisize;
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN)
+		return (0);
+
+	GuidedBilateralRowKernel simdRow = SelectedRowKernelInterleaved(demisize, nchan);
+	GuidedBilateralRowKernel scalarRow = GuidedBilateralSelectRow<GuidedBilateralRowScalarInterleaved>(demisize, nchan);
+
+	/* alloc, one float plane per channel */
+	float *filtered = new float[nchan * plane];
+
+	/* init image */
+	for (int i = 0; i < plane; i++)
+		for (int c = 0; c < nchan; c++)
+			filtered[c * plane + i] = (float)(orig[i * nchan + c]);
+
+	/* GNC and final iterations */
+	GuidedBilateralRunSteps(dimx, dimy, tables->num, nchan * (sizeof(float) + 2), [&](int s, int j, int ibegin, int iend)
+	{
+		GuidedBilateralFilterSpanInterleaved(dimx, dimy, nchan, orig, guide, demisize, tables->swindow[s], tables->iweight[s], tables->gweight[s], filtered,
+											 simdRow, scalarRow, j, ibegin, iend);
+	});
+
+	for (int i = 0; i < plane; i++)
+		for (int c = 0; c < nchan; c++)
+			result[i * nchan + c] = (unsigned char)(filtered[c * plane + i]);
+
+	delete[] filtered;
+
+	return (1);
+}
+
+// Fused II + IJ pixel: the IJ accumulators run GuidedBilateralFilterPixelInterleaved guided by guide, the II ones
+// guided by orig, in the same order. The neighbor values and the spatial weight are read once for both.
+template <bool Border, int Radius, int NChan>
+static inline void GuidedBilateralFilterPixelDual(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+												  float const *swindow, float const *iweight, float const *gweight, float *filteredIJ, float *filteredII,
+												  int i, int j)
+{
+	const int r = Radius > 0 ? Radius : demisize;
+	const int nc = NChan > 0 ? NChan : nchan;
+	const int plane = dimx * dimy;
+	int value, ediff, currentGuide[GBF_MAX_NCHAN], currentOrig[GBF_MAX_NCHAN], diffGuide;
+	float wguide, poids, diff, rdiff;
+	float sommeIJ[GBF_MAX_NCHAN], pixelMoyIJ[GBF_MAX_NCHAN], currentIJ[GBF_MAX_NCHAN];
+	float sommeII[GBF_MAX_NCHAN], pixelMoyII[GBF_MAX_NCHAN], currentII[GBF_MAX_NCHAN];
+	for (int c = 0; c < nc; c++)
+	{
+		sommeIJ[c] = sommeII[c] = 1e-6f;
+		pixelMoyIJ[c] = pixelMoyII[c] = 0.0f;
+		currentIJ[c] = filteredIJ[c * plane + j * dimx + i];
+		currentII[c] = filteredII[c * plane + j * dimx + i];
+		currentGuide[c] = guide[j * guideStride + i * nc + c];
+		currentOrig[c] = orig[j * origStride + i * nc + c];
+	}
+
+	for (int k = -r; k <= r; k++)
+	{
+		if (!Border || ((j + k >= 0) && (j + k < dimy)))
+		{
+			float const *sw = swindow + (k + r) * (2 * r + 1) + r;
+			for (int l = -r; l <= r; l++)
+			{
+				if (!Border || ((i + l >= 0) && (i + l < dimx)))
+				{
+					const int pixel = (j + k) * origStride + (i + l) * nc, guidePixel = (j + k) * guideStride + (i + l) * nc;
+					for (int c = 0; c < nc; c++)
+					{
+						value = orig[pixel + c];
+
+						diff = fabs((float)value - currentIJ[c]);
+						ediff = (int)diff; // diff >= 0, truncation is the floor
+						rdiff = diff - (float)ediff;
+						diffGuide = abs(guide[guidePixel + c] - currentGuide[c]);
+						wguide = gweight[diffGuide];
+						poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * sw[l] * wguide;
+						sommeIJ[c] += poids;
+						pixelMoyIJ[c] += poids * (float)value;
+
+						diff = fabs((float)value - currentII[c]);
+						ediff = (int)diff;
+						rdiff = diff - (float)ediff;
+						diffGuide = abs(value - currentOrig[c]);
+						wguide = gweight[diffGuide];
+						poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * sw[l] * wguide;
+						sommeII[c] += poids;
+						pixelMoyII[c] += poids * (float)value;
+					}
+				}
+			}
+		}
+	}
+
+	for (int c = 0; c < nc; c++)
+	{
+		filteredIJ[c * plane + j * dimx + i] = pixelMoyIJ[c] / sommeIJ[c];
+		filteredII[c * plane + j * dimx + i] = pixelMoyII[c] / sommeII[c];
+	}
+}
+
+template <int Radius, int NChan>
+struct GuidedBilateralRowScalarDual
+{
+	static int run(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+				   float const *swindow, float const *iweight, float const *gweight, float *filteredIJ, float *filteredII,
+				   int j, int ibegin, int iend)
+	{
+		for (int i = ibegin; i < iend; i++)
+			GuidedBilateralFilterPixelDual<false, Radius, NChan>(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, swindow, iweight, gweight, filteredIJ, filteredII, i, j);
+		return iend;
+	}
+};
+
+// same split as GuidedBilateralFilterSpanInterleaved
+static void GuidedBilateralFilterSpanDual(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+										  float const *swindow, float const *iweight, float const *gweight, float *filteredIJ, float *filteredII,
+										  GuidedBilateralDualRowKernel simdRow, GuidedBilateralDualRowKernel scalarRow, int j, int ibegin, int iend)
+{
+	int i = ibegin;
+	if (j >= demisize && j < dimy - demisize && dimx > 2 * demisize)
+	{
+		const int inner = iend < dimx - demisize ? iend : dimx - demisize;
+		const int simdEnd = iend < dimx - demisize - 2 ? iend : dimx - demisize - 2;
+		for (; i < demisize && i < iend; i++)
+			GuidedBilateralFilterPixelDual<true, 0, 0>(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, swindow, iweight, gweight, filteredIJ, filteredII, i, j);
+		if (simdRow && i < simdEnd)
+			i = simdRow(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, swindow, iweight, gweight, filteredIJ, filteredII, j, i, simdEnd);
+		if (i < inner)
+			i = scalarRow(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, swindow, iweight, gweight, filteredIJ, filteredII, j, i, inner);
+	}
+	for (; i < iend; i++)
+		GuidedBilateralFilterPixelDual<true, 0, 0>(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, swindow, iweight, gweight, filteredIJ, filteredII, i, j);
+}
+
+int GuidedBilateralFilterStepDual(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+								  float sscale, float iscale, float ipower, float gscale, float gpower, float *filteredIJ, float *filteredII)
+{
+	float const *swindow, *iweight, *gweight;
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN)
+		return (0);
+	if (!GuidedBilateralWeights(demisize, sscale, iscale, ipower, gscale, gpower, &swindow, &iweight, &gweight))
+		return (0);
+
+	GuidedBilateralDualRowKernel simdRow = SelectedRowKernelDual(demisize, nchan);
+	GuidedBilateralDualRowKernel scalarRow = GuidedBilateralSelectRow<GuidedBilateralRowScalarDual>(demisize, nchan);
+
+	GuidedBilateralRunSteps(dimx, dimy, 1, nchan * (2 * sizeof(float) + 2), [&](int, int j, int ibegin, int iend)
+	{
+		GuidedBilateralFilterSpanDual(dimx, dimy, nchan, orig, dimx * nchan, guide, dimx * nchan, demisize, swindow, iweight, gweight, filteredIJ, filteredII, simdRow, scalarRow, j, ibegin, iend);
+	});
+
+	return (1);
+}
+
+// One static weight of a plane, decoded like GuidedBilateralLoadWeights
+template <int Precision>
+static inline float GuidedBilateralStaticWeight(void const *weights, size_t index)
+{
+	if (Precision == GBF_STATIC_F16)
+	{
+		// the half bits in the float exponent and mantissa, then the exponent bias and GBF_HALF_SCALE undone
+		unsigned int bits = (unsigned int)((unsigned short const *)weights)[index] << 13;
+		float x;
+		memcpy(&x, &bits, sizeof(x));
+		return x * GBF_HALF_UNSCALE;
+	}
+	else if (Precision == GBF_STATIC_U8)
+		return (float)((unsigned char const *)weights)[index] * (1.0f / 255.0f);
+	else
+		return ((float const *)weights)[index];
+}
+
+static inline void GuidedBilateralStoreStaticWeight(void *weights, size_t index, float w, GuidedBilateralPrecision precision)
+{
+	if (precision == GBF_STATIC_F16)
+	{
+		// normal halves only, rounded to nearest even. w <= 1, w * 2^14 is far below the largest half
+		float x = w * GBF_HALF_SCALE;
+		unsigned int bits;
+		memcpy(&bits, &x, sizeof(bits));
+		((unsigned short *)weights)[index] = x < 6.103515625e-05f ? 0 : (unsigned short)((bits - (112u << 23) + 0xfff + ((bits >> 13) & 1)) >> 13);
+	}
+	else if (precision == GBF_STATIC_U8)
+		((unsigned char *)weights)[index] = (unsigned char)(w * 255.0f + 0.5f);
+	else
+		((float *)weights)[index] = w < FLT_MIN ? 0.0f : w;
+}
+
+size_t GuidedBilateralStaticBytes(int dimx, int dimy, int nchan, int demisize, GuidedBilateralPrecision precision)
+{
+	const size_t size = 2 * demisize + 1;
+	const size_t bytes = precision == GBF_STATIC_F16 ? 2 : precision == GBF_STATIC_U8 ? 1 : precision == GBF_STATIC_F32 ? 4 : 0;
+	return size * size * nchan * 2 * bytes * dimx * dimy;
+}
+
+// Computes the static weights of the pixels [ibegin, iend) of the row j: the spatial weight times the guide weight
+// of guide for IJ and of orig for II, 0 for the neighbors out of the image
+static void GuidedBilateralStaticSpan(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+									  float const *swindow, float const *gweight, GuidedBilateralPrecision precision, void *weights,
+									  int j, int ibegin, int iend)
+{
+	const size_t plane = (size_t)dimx * dimy;
+	const int size = 2 * demisize + 1;
+
+	for (int k = -demisize; k <= demisize; k++)
+		for (int l = -demisize; l <= demisize; l++)
+		{
+			const int n = (k + demisize) * size + l + demisize;
+			for (int c = 0; c < nchan; c++)
+				for (int f = 0; f < 2; f++)
+				{
+					unsigned char const *ref = f == 0 ? guide : orig;
+					const int stride = f == 0 ? guideStride : origStride;
+					const size_t base = ((size_t)(n * nchan + c) * 2 + f) * plane + (size_t)j * dimx;
+					for (int i = ibegin; i < iend; i++)
+					{
+						float w = 0.0f;
+						if (j + k >= 0 && j + k < dimy && i + l >= 0 && i + l < dimx)
+							w = swindow[n] * gweight[abs(ref[(j + k) * stride + (i + l) * nchan + c] - ref[j * stride + i * nchan + c])];
+						GuidedBilateralStoreStaticWeight(weights, base + i, w, precision);
+					}
+				}
+		}
+}
+
+// GuidedBilateralFilterPixelDual on the static weights: interp * (sw * wguide) instead of (interp * sw) * wguide,
+// close to the dynamic result but not bit identical
+template <bool Border, int Radius, int NChan, int Precision>
+static inline void GuidedBilateralFilterPixelDualStatic(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, int demisize,
+														float const *iweight, void const *weights, float *filteredIJ, float *filteredII,
+														int i, int j)
+{
+	const int r = Radius > 0 ? Radius : demisize;
+	const int nc = NChan > 0 ? NChan : nchan;
+	const size_t plane = (size_t)dimx * dimy;
+	int value, ediff;
+	float interp, poids, diff, rdiff;
+	float sommeIJ[GBF_MAX_NCHAN], pixelMoyIJ[GBF_MAX_NCHAN], currentIJ[GBF_MAX_NCHAN];
+	float sommeII[GBF_MAX_NCHAN], pixelMoyII[GBF_MAX_NCHAN], currentII[GBF_MAX_NCHAN];
+	for (int c = 0; c < nc; c++)
+	{
+		sommeIJ[c] = sommeII[c] = 1e-6f;
+		pixelMoyIJ[c] = pixelMoyII[c] = 0.0f;
+		currentIJ[c] = filteredIJ[c * plane + j * dimx + i];
+		currentII[c] = filteredII[c * plane + j * dimx + i];
+	}
+
+	for (int k = -r; k <= r; k++)
+	{
+		if (!Border || ((j + k >= 0) && (j + k < dimy)))
+		{
+			for (int l = -r; l <= r; l++)
+			{
+				if (!Border || ((i + l >= 0) && (i + l < dimx)))
+				{
+					const int pixel = (j + k) * origStride + (i + l) * nc;
+					size_t w = (size_t)((k + r) * (2 * r + 1) + l + r) * nc * 2 * plane + (size_t)j * dimx + i;
+					for (int c = 0; c < nc; c++, w += 2 * plane)
+					{
+						value = orig[pixel + c];
+
+						diff = fabs((float)value - currentIJ[c]);
+						ediff = (int)diff; // diff >= 0, truncation is the floor
+						rdiff = diff - (float)ediff;
+						interp = (1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1];
+						poids = interp * GuidedBilateralStaticWeight<Precision>(weights, w);
+						sommeIJ[c] += poids;
+						pixelMoyIJ[c] += poids * (float)value;
+
+						diff = fabs((float)value - currentII[c]);
+						ediff = (int)diff;
+						rdiff = diff - (float)ediff;
+						interp = (1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1];
+						poids = interp * GuidedBilateralStaticWeight<Precision>(weights, w + plane);
+						sommeII[c] += poids;
+						pixelMoyII[c] += poids * (float)value;
+					}
+				}
+			}
+		}
+	}
+
+	for (int c = 0; c < nc; c++)
+	{
+		filteredIJ[c * plane + j * dimx + i] = pixelMoyIJ[c] / sommeIJ[c];
+		filteredII[c * plane + j * dimx + i] = pixelMoyII[c] / sommeII[c];
+	}
+}
+
+template <int Precision>
+struct GuidedBilateralRowScalarDualStatic
+{
+	template <int Radius, int NChan>
+	struct Kernel
+	{
+		static int run(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, int demisize,
+					   float const *iweight, void const *weights, float *filteredIJ, float *filteredII,
+					   int j, int ibegin, int iend)
+		{
+			for (int i = ibegin; i < iend; i++)
+				GuidedBilateralFilterPixelDualStatic<false, Radius, NChan, Precision>(dimx, dimy, nchan, orig, origStride, demisize, iweight, weights, filteredIJ, filteredII, i, j);
+			return iend;
+		}
+	};
+};
+
+// same split as GuidedBilateralFilterSpanDual
+template <int Precision>
+static void GuidedBilateralFilterSpanDualStatic(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, int demisize,
+												float const *iweight, void const *weights, float *filteredIJ, float *filteredII,
+												GuidedBilateralDualStaticRowKernel simdRow, GuidedBilateralDualStaticRowKernel scalarRow, int j, int ibegin, int iend)
+{
+	int i = ibegin;
+	if (j >= demisize && j < dimy - demisize && dimx > 2 * demisize)
+	{
+		const int inner = iend < dimx - demisize ? iend : dimx - demisize;
+		const int simdEnd = iend < dimx - demisize - 2 ? iend : dimx - demisize - 2;
+		for (; i < demisize && i < iend; i++)
+			GuidedBilateralFilterPixelDualStatic<true, 0, 0, Precision>(dimx, dimy, nchan, orig, origStride, demisize, iweight, weights, filteredIJ, filteredII, i, j);
+		if (simdRow && i < simdEnd)
+			i = simdRow(dimx, dimy, nchan, orig, origStride, demisize, iweight, weights, filteredIJ, filteredII, j, i, simdEnd);
+		if (i < inner)
+			i = scalarRow(dimx, dimy, nchan, orig, origStride, demisize, iweight, weights, filteredIJ, filteredII, j, i, inner);
+	}
+	for (; i < iend; i++)
+		GuidedBilateralFilterPixelDualStatic<true, 0, 0, Precision>(dimx, dimy, nchan, orig, origStride, demisize, iweight, weights, filteredIJ, filteredII, i, j);
+}
+
+typedef void (*GuidedBilateralDualStaticSpan)(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, int demisize,
+											  float const *iweight, void const *weights, float *filteredIJ, float *filteredII,
+											  GuidedBilateralDualStaticRowKernel simdRow, GuidedBilateralDualStaticRowKernel scalarRow, int j, int ibegin, int iend);
+
+int GuidedBilateralScreenTile(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride,
+							  GuidedBilateralTables const *tables, int threshold, int jbegin, int jend, int ibegin, int iend)
+{
+	const int r = tables->demisize;
+
+	// the center weight of a window bounds the share of the 1e-6 of the sums: below it a result may lose a level
+	// more than the minimum of its window
+	float center = 1.0f;
+	for (int s = 0; s < tables->num; s++)
+		for (int d = 0; d <= 256; d++)
+		{
+			const float w = tables->iweight[s][d] * tables->gweight[s][0] * tables->swindow[s][r * (2 * r + 1) + r];
+			center = w < center ? w : center;
+		}
+	if (center < GBF_SCREEN_MIN_WEIGHT)
+		return (0);
+
+	// the tile and its halo
+	const int x0 = ibegin - r > 0 ? ibegin - r : 0, x1 = iend + r < dimx ? iend + r : dimx;
+	const int y0 = jbegin - r > 0 ? jbegin - r : 0, y1 = jend + r < dimy ? jend + r : dimy;
+	for (int c = 0; c < nchan; c++)
+	{
+		const int offset = guide[y0 * guideStride + x0 * nchan + c] - orig[y0 * origStride + x0 * nchan + c];
+		int low = 255, high = 0;
+		bool shifted = true;
+		for (int y = y0; y < y1; y++)
+			for (int x = x0; x < x1; x++)
+			{
+				const int value = orig[y * origStride + x * nchan + c];
+				low = value < low ? value : low;
+				high = value > high ? value : high;
+				shifted = shifted && guide[y * guideStride + x * nchan + c] - value == offset;
+			}
+		// II and IJ between low - 1 and high, or equal
+		if (high - low + 1 > threshold && !shifted)
+			return (0);
+	}
+
+	return (1);
+}
+
+int GuidedBilateralFilterDualScratch(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride,
+									 GuidedBilateralTables const *tables, float *scratch, unsigned char *resultIJ, int resultIJStride,
+									 unsigned char *resultII, int resultIIStride, GuidedBilateralConvergence *convergence, GuidedBilateralPrecision precision, void *weights,
+									 GuidedBilateralDoneCallback done, void *user, GuidedBilateralSkipCallback skip)
+{
+	const int plane = dimx * dimy;
+	const int demisize = tables->demisize;
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN)
+		return (0);
+	if (precision != GBF_STATIC_NONE && weights == NULL)
+		return (0);
+	// the f16 and u8 planes hold weights up to 1, not the GBF_POLICY_SUM_SCALE guide weights of the bilateral policy
+	if (precision == GBF_STATIC_F16 || precision == GBF_STATIC_U8)
+		for (int s = 0; s < tables->num; s++)
+			if (tables->gweight[s][0] > 1.0f)
+				return (0);
+
+	GuidedBilateralDualRowKernel simdRow = SelectedRowKernelDual(demisize, nchan);
+	GuidedBilateralDualRowKernel scalarRow = GuidedBilateralSelectRow<GuidedBilateralRowScalarDual>(demisize, nchan);
+
+	/* static weights for the steps with the guide and spatial parameters of the last one, when there are several */
+	bool isStatic[GBF_MAX_STEPS];
+	int staticFirst = -1, staticCount = 0;
+	for (int s = 0; s < tables->num; s++)
+	{
+		const GuidedBilateralStepParams &p = tables->steps[s], &last = tables->steps[tables->num - 1];
+		isStatic[s] = p.sscale == last.sscale && p.gscale == last.gscale && p.gpower == last.gpower;
+		if (isStatic[s] && staticFirst < 0)
+			staticFirst = s;
+		staticCount += isStatic[s];
+	}
+	if (precision == GBF_STATIC_NONE || staticCount < 2)
+		staticFirst = tables->num;
+
+	GuidedBilateralDualStaticRowKernel staticSimdRow = NULL, staticScalarRow = NULL;
+	GuidedBilateralDualStaticSpan staticSpan = NULL;
+	int pixbytes = nchan * (2 * sizeof(float) + 2);
+	if (staticFirst < tables->num)
+	{
+		staticSimdRow = SelectedRowKernelDualStatic(demisize, nchan, precision);
+		staticScalarRow = GuidedBilateralSelectRowStatic<GuidedBilateralRowScalarDualStatic>(demisize, nchan, precision);
+		staticSpan = precision == GBF_STATIC_F16 ? GuidedBilateralFilterSpanDualStatic<GBF_STATIC_F16>
+				   : precision == GBF_STATIC_U8	 ? GuidedBilateralFilterSpanDualStatic<GBF_STATIC_U8>
+												 : GuidedBilateralFilterSpanDualStatic<GBF_STATIC_F32>;
+		pixbytes += (int)GuidedBilateralStaticBytes(1, 1, nchan, demisize, precision);
+	}
+
+	/* one float plane per channel and filter */
+	float *filteredIJ = scratch;
+	float *filteredII = filteredIJ + nchan * plane;
+
+	/* without GNC step the first step is tracked, its changes are measured from orig */
+	if (convergence && tables->gnc == 0)
+		for (int j = 0; j < dimy; j++)
+			for (int i = 0; i < dimx; i++)
+				for (int c = 0; c < nchan; c++)
+					filteredIJ[c * plane + j * dimx + i] = filteredII[c * plane + j * dimx + i] = (float)(orig[j * origStride + i * nchan + c]);
+
+	/* GNC and final iterations, every span starts from orig at the first step and every tile ends with its results */
+	GuidedBilateralTrack track = {scratch, 2 * nchan, tables->gnc, convergence};
+	GuidedBilateralRunSteps(dimx, dimy, tables->num, pixbytes, [&](int s, int j, int ibegin, int iend)
+	{
+		if (s == 0)
+			for (int i = ibegin; i < iend; i++)
+				for (int c = 0; c < nchan; c++)
+					filteredIJ[c * plane + j * dimx + i] = filteredII[c * plane + j * dimx + i] = (float)(orig[j * origStride + i * nchan + c]);
+		// every span goes through the first static step, the final iterations drop segments only after it
+		if (s >= staticFirst && isStatic[s])
+		{
+			if (s == staticFirst)
+				GuidedBilateralStaticSpan(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, tables->swindow[s], tables->gweight[s], precision, weights, j, ibegin, iend);
+			staticSpan(dimx, dimy, nchan, orig, origStride, demisize, tables->iweight[s], weights, filteredIJ, filteredII, staticSimdRow, staticScalarRow, j, ibegin, iend);
+			return;
+		}
+		GuidedBilateralFilterSpanDual(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, tables->swindow[s], tables->iweight[s], tables->gweight[s], filteredIJ, filteredII,
+									  simdRow, scalarRow, j, ibegin, iend);
+	}, convergence ? &track : NULL, [&](int jbegin, int jend, int ibegin, int iend)
+	{
+		for (int j = jbegin; j < jend; j++)
+			for (int i = ibegin; i < iend; i++)
+				for (int c = 0; c < nchan; c++)
+				{
+					resultIJ[j * resultIJStride + i * nchan + c] = (unsigned char)(filteredIJ[c * plane + j * dimx + i]);
+					resultII[j * resultIIStride + i * nchan + c] = (unsigned char)(filteredII[c * plane + j * dimx + i]);
+				}
+		if (done)
+			done(user, jbegin, jend, ibegin, iend);
+	}, skip, user);
+
+	return (1);
+}
+
+int GuidedBilateralFilterDualStrip(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride,
+								   int top, int rows, GuidedBilateralTables const *tables, float *scratch,
+								   unsigned char *resultIJ, int resultIJStride, unsigned char *resultII, int resultIIStride)
+{
+	const int plane = dimx * dimy;
+	const int demisize = tables->demisize;
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN || top < 0 || rows < 0 || top + rows > dimy)
+		return (0);
+
+	GuidedBilateralDualRowKernel simdRow = SelectedRowKernelDual(demisize, nchan);
+	GuidedBilateralDualRowKernel scalarRow = GuidedBilateralSelectRow<GuidedBilateralRowScalarDual>(demisize, nchan);
+
+	/* planes of the whole window, the halo rows are only read from orig and guide */
+	float *filteredIJ = scratch;
+	float *filteredII = filteredIJ + nchan * plane;
+
+	/* the steps over the rows of the strip, row j of the loop being the row top + j of the window */
+	GuidedBilateralRunSteps(dimx, rows, tables->num, nchan * (2 * sizeof(float) + 2), [&](int s, int j, int ibegin, int iend)
+	{
+		j += top;
+		if (s == 0)
+			for (int i = ibegin; i < iend; i++)
+				for (int c = 0; c < nchan; c++)
+					filteredIJ[c * plane + j * dimx + i] = filteredII[c * plane + j * dimx + i] = (float)(orig[j * origStride + i * nchan + c]);
+		GuidedBilateralFilterSpanDual(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, tables->swindow[s], tables->iweight[s], tables->gweight[s],
+									  filteredIJ, filteredII, simdRow, scalarRow, j, ibegin, iend);
+	}, NULL, [&](int jbegin, int jend, int ibegin, int iend)
+	{
+		for (int j = jbegin; j < jend; j++)
+			for (int i = ibegin; i < iend; i++)
+				for (int c = 0; c < nchan; c++)
+				{
+					resultIJ[j * resultIJStride + i * nchan + c] = (unsigned char)(filteredIJ[c * plane + (top + j) * dimx + i]);
+					resultII[j * resultIIStride + i * nchan + c] = (unsigned char)(filteredII[c * plane + (top + j) * dimx + i]);
+				}
+	});
+
+	return (1);
+}
+
+size_t GuidedBilateralPyramidBytes(int dimx, int dimy, int nchan, int levels)
+{
+	if (levels <= 0)
+		return 0;
+	const size_t coarse = (size_t)((dimx + (1 << levels) - 1) >> levels) * ((dimy + (1 << levels) - 1) >> levels) * nchan;
+	// the float planes of the level, then its orig, guide and results
+	return 2 * coarse * sizeof(float) + 4 * coarse;
+}
+
+// mean of the pixels of the f x f block (i, j) of a channel, the blocks of the last row and column may be cut
+static inline unsigned char GuidedBilateralBlockMean(int dimx, int dimy, int nchan, unsigned char const *image, int stride, int f, int i, int j, int c)
+{
+	const int x1 = (i + 1) * f < dimx ? (i + 1) * f : dimx, y1 = (j + 1) * f < dimy ? (j + 1) * f : dimy;
+	int sum = 0;
+	for (int y = j * f; y < y1; y++)
+		for (int x = i * f; x < x1; x++)
+			sum += image[y * stride + x * nchan + c];
+	const int n = (x1 - i * f) * (y1 - j * f);
+	return (unsigned char)((sum + n / 2) / n);
+}
+
+// bilinear sample of the float planes of the coarse level at the pixel (i, j) of the image, pixel centers aligned
+static inline void GuidedBilateralUpsample(int cx, int cy, int nchan, float const *coarse, float scale, int i, int j, float *values)
+{
+	float x = ((float)i + 0.5f) * scale - 0.5f, y = ((float)j + 0.5f) * scale - 0.5f;
+	x = x < 0.0f ? 0.0f : x > (float)(cx - 1) ? (float)(cx - 1) : x;
+	y = y < 0.0f ? 0.0f : y > (float)(cy - 1) ? (float)(cy - 1) : y;
+	const int x0 = (int)x, y0 = (int)y;
+	const int x1 = x0 + 1 < cx ? x0 + 1 : x0, y1 = y0 + 1 < cy ? y0 + 1 : y0;
+	const float rx = x - (float)x0, ry = y - (float)y0;
+	for (int c = 0; c < nchan; c++)
+	{
+		float const *p = coarse + c * cx * cy;
+		const float top = (1.0f - rx) * p[y0 * cx + x0] + rx * p[y0 * cx + x1];
+		const float bottom = (1.0f - rx) * p[y1 * cx + x0] + rx * p[y1 * cx + x1];
+		values[c] = (1.0f - ry) * top + ry * bottom;
+	}
+}
+
+int GuidedBilateralFilterDualPyramid(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride,
+									 GuidedBilateralTables const *tables, int levels, float *scratch, void *pyramid,
+									 unsigned char *resultIJ, int resultIJStride, unsigned char *resultII, int resultIIStride,
+									 GuidedBilateralDoneCallback done, void *user)
+{
+	const int plane = dimx * dimy;
+	const int demisize = tables->demisize, gnc = tables->gnc;
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN || levels < 0 || levels > GBF_PYRAMID_MAX_LEVELS)
+		return (0);
+	// nothing to warm up, or a level of a single pixel
+	if (levels == 0 || gnc == 0 || (dimx >> levels) < 1 || (dimy >> levels) < 1)
+		return GuidedBilateralFilterDualScratch(dimx, dimy, nchan, orig, origStride, guide, guideStride, tables, scratch, resultIJ, resultIJStride,
+												resultII, resultIIStride, NULL, GBF_STATIC_NONE, NULL, done, user);
+	if (pyramid == NULL)
+		return (0);
+
+	/* the level: box means of orig and guide, the warm-up steps on them with the same tables */
+	const int f = 1 << levels, cx = (dimx + f - 1) >> levels, cy = (dimy + f - 1) >> levels, crow = cx * nchan;
+	float *coarse = (float *)pyramid;
+	unsigned char *corig = (unsigned char *)(coarse + 2 * (size_t)nchan * cx * cy);
+	unsigned char *cguide = corig + (size_t)crow * cy, *cij = cguide + (size_t)crow * cy, *cii = cij + (size_t)crow * cy;
+
+	#pragma omp parallel for schedule(static)
+	for (int j = 0; j < cy; j++)
+		for (int i = 0; i < cx; i++)
+			for (int c = 0; c < nchan; c++)
+			{
+				corig[j * crow + i * nchan + c] = GuidedBilateralBlockMean(dimx, dimy, nchan, orig, origStride, f, i, j, c);
+				cguide[j * crow + i * nchan + c] = GuidedBilateralBlockMean(dimx, dimy, nchan, guide, guideStride, f, i, j, c);
+			}
+
+	GuidedBilateralTables warmup = *tables;
+	warmup.num = gnc;
+	if (!GuidedBilateralFilterDualScratch(cx, cy, nchan, corig, crow, cguide, crow, &warmup, coarse, cij, crow, cii, crow))
+		return (0);
+
+	GuidedBilateralDualRowKernel simdRow = SelectedRowKernelDual(demisize, nchan);
+	GuidedBilateralDualRowKernel scalarRow = GuidedBilateralSelectRow<GuidedBilateralRowScalarDual>(demisize, nchan);
+
+	float *filteredIJ = scratch;
+	float *filteredII = filteredIJ + nchan * plane;
+	float const *coarseIJ = coarse, *coarseII = coarse + nchan * cx * cy;
+	const float scale = 1.0f / (float)f;
+
+	/* the final iterations at full resolution from the upsampled estimate, the warm-up steps are empty here and
+	   keep their numbers for the step timing */
+	GuidedBilateralRunSteps(dimx, dimy, tables->num, nchan * (2 * sizeof(float) + 2), [&](int s, int j, int ibegin, int iend)
+	{
+		if (s < gnc)
+			return;
+		if (s == gnc)
+			for (int i = ibegin; i < iend; i++)
+			{
+				float ij[GBF_MAX_NCHAN], ii[GBF_MAX_NCHAN];
+				GuidedBilateralUpsample(cx, cy, nchan, coarseIJ, scale, i, j, ij);
+				GuidedBilateralUpsample(cx, cy, nchan, coarseII, scale, i, j, ii);
+				for (int c = 0; c < nchan; c++)
+				{
+					filteredIJ[c * plane + j * dimx + i] = ij[c];
+					filteredII[c * plane + j * dimx + i] = ii[c];
+				}
+			}
+		GuidedBilateralFilterSpanDual(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, tables->swindow[s], tables->iweight[s], tables->gweight[s],
+									  filteredIJ, filteredII, simdRow, scalarRow, j, ibegin, iend);
+	}, NULL, [&](int jbegin, int jend, int ibegin, int iend)
+	{
+		for (int j = jbegin; j < jend; j++)
+			for (int i = ibegin; i < iend; i++)
+				for (int c = 0; c < nchan; c++)
+				{
+					resultIJ[j * resultIJStride + i * nchan + c] = (unsigned char)(filteredIJ[c * plane + j * dimx + i]);
+					resultII[j * resultIIStride + i * nchan + c] = (unsigned char)(filteredII[c * plane + j * dimx + i]);
+				}
+		if (done)
+			done(user, jbegin, jend, ibegin, iend);
+	});
+
+	return (1);
+}
+
+// bookkeeping of one pair of GuidedBilateralFilterDualBatch
+struct GuidedBilateralBatchJob
+{
+	GuidedBilateralTiling tiling;
+	GuidedBilateralTrack track;
+	float *filteredIJ, *filteredII;
+	int firstTile, iterations;
+	double pixelSteps;
+};
+
+int GuidedBilateralFilterDualBatch(int count, GuidedBilateralPair const *pairs, int nchan, GuidedBilateralTables const *tables, float *scratch)
+{
+	const int demisize = tables->demisize;
+	const int pixbytes = nchan * (2 * sizeof(float) + 2);
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN)
+		return (0);
+	if (count <= 0)
+		return (1);
+
+	GuidedBilateralDualRowKernel simdRow = SelectedRowKernelDual(demisize, nchan);
+	GuidedBilateralDualRowKernel scalarRow = GuidedBilateralSelectRow<GuidedBilateralRowScalarDual>(demisize, nchan);
+
+	/* float planes and tiles of every pair, the thread balance cut of a lone image is left to the batch size */
+	GuidedBilateralBatchJob *jobs = new GuidedBilateralBatchJob[count];
+	float *planes = scratch;
+	int ntiles = 0;
+	for (int p = 0; p < count; p++)
+	{
+		const GuidedBilateralPair &pair = pairs[p];
+		GuidedBilateralBatchJob &job = jobs[p];
+		job.tiling = GuidedBilateralTiles(pair.dimx, pair.dimy, pixbytes, pair.convergence != NULL, count == 1);
+		job.filteredIJ = planes;
+		job.filteredII = planes + nchan * pair.dimx * pair.dimy;
+		job.track.filtered = planes;
+		job.track.nplanes = 2 * nchan;
+		job.track.gnc = tables->gnc;
+		job.track.convergence = pair.convergence;
+		job.firstTile = ntiles;
+		job.iterations = tables->gnc;
+		job.pixelSteps = 0.0;
+		planes += 2 * nchan * pair.dimx * pair.dimy;
+		ntiles += job.tiling.ntilex * job.tiling.ntiley;
+	}
+
+	/* init images, both filters start from orig */
+	#pragma omp parallel for schedule(dynamic)
+	for (int p = 0; p < count; p++)
+	{
+		const GuidedBilateralPair &pair = pairs[p];
+		const int plane = pair.dimx * pair.dimy;
+		for (int j = 0; j < pair.dimy; j++)
+			for (int i = 0; i < pair.dimx; i++)
+				for (int c = 0; c < nchan; c++)
+					jobs[p].filteredIJ[c * plane + j * pair.dimx + i] = jobs[p].filteredII[c * plane + j * pair.dimx + i] = (float)(pair.orig[j * pair.origStride + i * nchan + c]);
+	}
+
+	/* GNC and final iterations, the tiles of all the pairs in one loop */
+	#pragma omp parallel for schedule(dynamic)
+	for (int t = 0; t < ntiles; t++)
+	{
+		// last pair starting at or before t
+		int low = 0, high = count - 1;
+		while (low < high)
+		{
+			const int mid = (low + high + 1) / 2;
+			if (jobs[mid].firstTile <= t)
+				low = mid;
+			else
+				high = mid - 1;
+		}
+		const GuidedBilateralPair &pair = pairs[low];
+		GuidedBilateralBatchJob &job = jobs[low];
+		auto span = [&](int s, int j, int ibegin, int iend)
+		{
+			GuidedBilateralFilterSpanDual(pair.dimx, pair.dimy, nchan, pair.orig, pair.origStride, pair.guide, pair.guideStride, demisize, tables->swindow[s], tables->iweight[s], tables->gweight[s],
+										  job.filteredIJ, job.filteredII, simdRow, scalarRow, j, ibegin, iend);
+		};
+		int iterations = tables->gnc;
+		double pixelSteps = 0.0;
+		GuidedBilateralRunTile(job.tiling, t - job.firstTile, tables->num, span, pair.convergence ? &job.track : NULL, iterations, pixelSteps);
+		if (pair.convergence)
+		{
+			#pragma omp critical(GuidedBilateralBatchTrack)
+			{
+				if (iterations > job.iterations)
+					job.iterations = iterations;
+				job.pixelSteps += pixelSteps;
+			}
+		}
+	}
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int p = 0; p < count; p++)
+	{
+		const GuidedBilateralPair &pair = pairs[p];
+		const int plane = pair.dimx * pair.dimy;
+		for (int j = 0; j < pair.dimy; j++)
+			for (int i = 0; i < pair.dimx; i++)
+				for (int c = 0; c < nchan; c++)
+				{
+					pair.resultIJ[j * pair.resultIJStride + i * nchan + c] = (unsigned char)(jobs[p].filteredIJ[c * plane + j * pair.dimx + i]);
+					pair.resultII[j * pair.resultIIStride + i * nchan + c] = (unsigned char)(jobs[p].filteredII[c * plane + j * pair.dimx + i]);
+				}
+		if (pair.convergence)
+		{
+			pair.convergence->iterations = jobs[p].iterations;
+			pair.convergence->meanIterations = (float)(jobs[p].pixelSteps / (double)plane);
+		}
+	}
+
+	delete[] jobs;
+
+	return (1);
+}
+
+int GuidedBilateralFilterDual(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+							  float sscale, float iscale, float ipower, float gscale, float gpower, unsigned char *resultIJ, unsigned char *resultII)
+{
+	GuidedBilateralTables tables;
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN)
+		return (0);
+	if (!GuidedBilateralBuildTables(demisize, sscale, iscale, ipower, gscale, gpower, &tables))
+		return (0);
+
+	/* alloc */
+	float *scratch = new float[2 * nchan * dimx * dimy];
+
+	int ok = GuidedBilateralFilterDualScratch(dimx, dimy, nchan, orig, dimx * nchan, guide, dimx * nchan, &tables, scratch, resultIJ, dimx * nchan, resultII, dimx * nchan);
+
+	delete[] scratch;
+	GuidedBilateralFreeTables(&tables);
+
+	return ok;
+}
+
+int GuidedBilateralBuildFixedTables(GuidedBilateralTables const *tables, GuidedBilateralFixedTables *fixed)
+{
+	if (tables->demisize > GBF_FIXED_MAX_DEMISIZE)
+		return (0);
+
+	for (int s = 0; s < tables->num; s++)
+	{
+		// ipower above 1 gives intensity weights above 1, out of Q15: a step only uses the ratios of its weights,
+		// the table is scaled to a largest weight of 1
+		float largest = 1.0f;
+		for (int d = 0; d <= 255; d++)
+			largest = tables->iweight[s][d] > largest ? tables->iweight[s][d] : largest;
+
+		// the float interpolation at every 1 / 2^GBF_FIXED_LUT_SHIFT level
+		for (int d = 0; d < GBF_FIXED_LUT_SIZE; d++)
+		{
+			const int ediff = d >> (8 - GBF_FIXED_LUT_SHIFT);
+			const float rdiff = (float)(d & ((1 << (8 - GBF_FIXED_LUT_SHIFT)) - 1)) / (float)(1 << (8 - GBF_FIXED_LUT_SHIFT));
+			fixed->iweight[s][d] = GuidedBilateralFixed(((1.0f - rdiff) * tables->iweight[s][ediff] + rdiff * tables->iweight[s][ediff + 1]) / largest);
+		}
+		// same for the guide weights, the policies of GuidedBilateralBuildPolicyTables scale them
+		float largestGuide = 1.0f;
+		for (int d = 0; d <= 255; d++)
+			largestGuide = tables->gweight[s][d] > largestGuide ? tables->gweight[s][d] : largestGuide;
+		for (int d = 0; d < 256; d++)
+			fixed->gweight[s][d] = GuidedBilateralFixed(tables->gweight[s][d] / largestGuide);
+	}
+
+	return (1);
+}
+
+template <bool Border, int Radius, int NChan>
+static inline void GuidedBilateralFilterPixelDualFixed(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+													   float const *swindow, int const *iweight, int const *gweight,
+													   unsigned short *filteredIJ, unsigned short *filteredII, int i, int j)
+{
+	const int r = Radius > 0 ? Radius : demisize;
+	const int nc = NChan > 0 ? NChan : nchan;
+	const int plane = dimx * dimy;
+	int value, spatial, interp, wguide, poids, currentGuide[GBF_MAX_NCHAN], currentOrig[GBF_MAX_NCHAN];
+	int sommeIJ[GBF_MAX_NCHAN], pixelMoyIJ[GBF_MAX_NCHAN], currentIJ[GBF_MAX_NCHAN];
+	int sommeII[GBF_MAX_NCHAN], pixelMoyII[GBF_MAX_NCHAN], currentII[GBF_MAX_NCHAN];
+	for (int c = 0; c < nc; c++)
+	{
+		sommeIJ[c] = sommeII[c] = pixelMoyIJ[c] = pixelMoyII[c] = 0;
+		currentIJ[c] = filteredIJ[c * plane + j * dimx + i];
+		currentII[c] = filteredII[c * plane + j * dimx + i];
+		currentGuide[c] = guide[j * guideStride + i * nc + c];
+		currentOrig[c] = orig[j * origStride + i * nc + c];
+	}
+
+	for (int k = -r; k <= r; k++)
+	{
+		if (!Border || ((j + k >= 0) && (j + k < dimy)))
+		{
+			float const *sw = swindow + (k + r) * (2 * r + 1) + r;
+			for (int l = -r; l <= r; l++)
+			{
+				if (!Border || ((i + l >= 0) && (i + l < dimx)))
+				{
+					const int pixel = (j + k) * origStride + (i + l) * nc, guidePixel = (j + k) * guideStride + (i + l) * nc;
+					spatial = GuidedBilateralFixed(sw[l]);
+					for (int c = 0; c < nc; c++)
+					{
+						value = orig[pixel + c];
+
+						// Q15 products, truncated like the unsigned shifts of the simd kernels
+						interp = iweight[abs((value << 8) - currentIJ[c]) >> GBF_FIXED_LUT_SHIFT];
+						wguide = gweight[abs(guide[guidePixel + c] - currentGuide[c])];
+						poids = (interp * ((spatial * wguide) >> GBF_FIXED_SHIFT)) >> GBF_FIXED_SHIFT;
+						sommeIJ[c] += poids;
+						pixelMoyIJ[c] += poids * value;
+
+						interp = iweight[abs((value << 8) - currentII[c]) >> GBF_FIXED_LUT_SHIFT];
+						wguide = gweight[abs(value - currentOrig[c])];
+						poids = (interp * ((spatial * wguide) >> GBF_FIXED_SHIFT)) >> GBF_FIXED_SHIFT;
+						sommeII[c] += poids;
+						pixelMoyII[c] += poids * value;
+					}
+				}
+			}
+		}
+	}
+
+	for (int c = 0; c < nc; c++)
+	{
+		filteredIJ[c * plane + j * dimx + i] = (unsigned short)((float)pixelMoyIJ[c] * 256.0f / (float)(sommeIJ[c] > 1 ? sommeIJ[c] : 1) + 0.5f);
+		filteredII[c * plane + j * dimx + i] = (unsigned short)((float)pixelMoyII[c] * 256.0f / (float)(sommeII[c] > 1 ? sommeII[c] : 1) + 0.5f);
+	}
+}
+
+template <int Radius, int NChan>
+struct GuidedBilateralRowScalarDualFixed
+{
+	static int run(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+				   float const *swindow, int const *iweight, int const *gweight,
+				   unsigned short *filteredIJ, unsigned short *filteredII, int j, int ibegin, int iend)
+	{
+		for (int i = ibegin; i < iend; i++)
+			GuidedBilateralFilterPixelDualFixed<false, Radius, NChan>(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, swindow, iweight, gweight, filteredIJ, filteredII, i, j);
+		return iend;
+	}
+};
+
+// same split as GuidedBilateralFilterSpanDual
+static void GuidedBilateralFilterSpanDualFixed(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+											   float const *swindow, int const *iweight, int const *gweight,
+											   unsigned short *filteredIJ, unsigned short *filteredII,
+											   GuidedBilateralDualFixedRowKernel simdRow, GuidedBilateralDualFixedRowKernel scalarRow, int j, int ibegin, int iend)
+{
+	int i = ibegin;
+	if (j >= demisize && j < dimy - demisize && dimx > 2 * demisize)
+	{
+		const int inner = iend < dimx - demisize ? iend : dimx - demisize;
+		const int simdEnd = iend < dimx - demisize - 2 ? iend : dimx - demisize - 2;
+		for (; i < demisize && i < iend; i++)
+			GuidedBilateralFilterPixelDualFixed<true, 0, 0>(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, swindow, iweight, gweight, filteredIJ, filteredII, i, j);
+		if (simdRow && i < simdEnd)
+			i = simdRow(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, swindow, iweight, gweight, filteredIJ, filteredII, j, i, simdEnd);
+		if (i < inner)
+			i = scalarRow(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, swindow, iweight, gweight, filteredIJ, filteredII, j, i, inner);
+	}
+	for (; i < iend; i++)
+		GuidedBilateralFilterPixelDualFixed<true, 0, 0>(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, swindow, iweight, gweight, filteredIJ, filteredII, i, j);
+}
+
+int GuidedBilateralFilterDualFixedScratch(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride,
+										  GuidedBilateralTables const *tables, GuidedBilateralFixedTables const *fixed, unsigned short *scratch,
+										  unsigned char *resultIJ, int resultIJStride, unsigned char *resultII, int resultIIStride,
+										  GuidedBilateralDoneCallback done, void *user)
+{
+	const int plane = dimx * dimy;
+	const int demisize = tables->demisize;
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN || demisize > GBF_FIXED_MAX_DEMISIZE)
+		return (0);
+
+	GuidedBilateralDualFixedRowKernel simdRow = SelectedRowKernelDualFixed(demisize, nchan);
+	GuidedBilateralDualFixedRowKernel scalarRow = GuidedBilateralSelectRow<GuidedBilateralRowScalarDualFixed>(demisize, nchan);
+
+	/* one 8.8 plane per channel and filter */
+	unsigned short *filteredIJ = scratch;
+	unsigned short *filteredII = filteredIJ + nchan * plane;
+
+	/* GNC and final iterations, like GuidedBilateralFilterDualScratch */
+	GuidedBilateralRunSteps(dimx, dimy, tables->num, nchan * (2 * sizeof(unsigned short) + 2), [&](int s, int j, int ibegin, int iend)
+	{
+		if (s == 0)
+			for (int i = ibegin; i < iend; i++)
+				for (int c = 0; c < nchan; c++)
+					filteredIJ[c * plane + j * dimx + i] = filteredII[c * plane + j * dimx + i] = (unsigned short)(orig[j * origStride + i * nchan + c] << 8);
+		GuidedBilateralFilterSpanDualFixed(dimx, dimy, nchan, orig, origStride, guide, guideStride, demisize, tables->swindow[s], fixed->iweight[s], fixed->gweight[s],
+										   filteredIJ, filteredII, simdRow, scalarRow, j, ibegin, iend);
+	}, NULL, [&](int jbegin, int jend, int ibegin, int iend)
+	{
+		for (int j = jbegin; j < jend; j++)
+			for (int i = ibegin; i < iend; i++)
+				for (int c = 0; c < nchan; c++)
+				{
+					resultIJ[j * resultIJStride + i * nchan + c] = (unsigned char)(filteredIJ[c * plane + j * dimx + i] >> 8);
+					resultII[j * resultIIStride + i * nchan + c] = (unsigned char)(filteredII[c * plane + j * dimx + i] >> 8);
+				}
+		if (done)
+			done(user, jbegin, jend, ibegin, iend);
+	});
+
+	return (1);
+}
@@ -0,0 +1,388 @@
+#ifndef CPU_FILTER_H
+#define CPU_FILTER_H
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "timing.h"
+
+// Guided bilateral filter, cpu implementation.
+// Images are planar 8 bit, pixel (i, j) is at j * dimx + i, the ncol guide planes are dimx * dimy apart.
+// The Interleaved variants take nchan channel images in the cv::Mat layout, channel c of pixel (i, j) at
+// (j * dimx + i) * nchan + c, and filter each channel guided by the same channel of guide.
+//
+// A step updates filtered in place without a second buffer: the neighbors are read from orig and guide, which
+// do not change, and filtered only at the pixel being written. The rows can run in any order on any thread
+// count with the same result, which is also the same on every kernel variant (no fma contraction).
+
+// kernel variants, the best one supported by the cpu is picked at startup
+enum GuidedBilateralKernel
+{
+	GBF_KERNEL_SCALAR = 0,
+	GBF_KERNEL_SSE42,
+	GBF_KERNEL_AVX2,
+	GBF_KERNEL_AVX512,
+	GBF_KERNEL_COUNT
+};
+
+GuidedBilateralKernel GuidedBilateralDetectKernel();
+bool GuidedBilateralKernelSupported(GuidedBilateralKernel kernel);
+// returns false and keeps the current kernel if the cpu does not support the requested one
+bool GuidedBilateralSetKernel(GuidedBilateralKernel kernel);
+GuidedBilateralKernel GuidedBilateralGetKernel();
+const char *GuidedBilateralKernelName(GuidedBilateralKernel kernel);
+
+// Filters the pixels [ibegin, iend) of the row j, all of them at least demisize away from the image border.
+// swindow holds the (2 * demisize + 1)^2 spatial weights sweight[|k|] * sweight[|l|], row by row.
+// The simd kernels process whole vectors only and return the first pixel left for the scalar code.
+typedef int (*GuidedBilateralRowKernel)(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+										float const *swindow, float const *iweight, float const *gweight, float *filtered,
+										int j, int ibegin, int iend);
+
+// Picks Row<Radius, NCol>::run, specialized for the window radii 1 to 5 and 1 or 3 guide channels,
+// or Row<0, 0>::run which reads demisize and ncol at runtime for the other sizes.
+template <template <int, int> class Row>
+decltype(&Row<0, 0>::run) GuidedBilateralSelectRow(int demisize, int ncol)
+{
+	if (ncol == 1 || ncol == 3)
+	{
+		switch (demisize)
+		{
+		case 1:
+			return ncol == 1 ? Row<1, 1>::run : Row<1, 3>::run;
+		case 2:
+			return ncol == 1 ? Row<2, 1>::run : Row<2, 3>::run;
+		case 3:
+			return ncol == 1 ? Row<3, 1>::run : Row<3, 3>::run;
+		case 4:
+			return ncol == 1 ? Row<4, 1>::run : Row<4, 3>::run;
+		case 5:
+			return ncol == 1 ? Row<5, 1>::run : Row<5, 3>::run;
+		}
+	}
+	return Row<0, 0>::run;
+}
+
+GuidedBilateralRowKernel GuidedBilateralSelectRowSSE42(int demisize, int ncol);
+GuidedBilateralRowKernel GuidedBilateralSelectRowAVX2(int demisize, int ncol);
+GuidedBilateralRowKernel GuidedBilateralSelectRowAVX512(int demisize, int ncol);
+
+// Same for interleaved images, the ncol argument is the channel count nchan and filtered holds nchan float planes.
+// The simd kernels must not reach the last two pixels of the image, their strided loads read a few bytes past the one they need.
+GuidedBilateralRowKernel GuidedBilateralSelectRowInterleavedSSE42(int demisize, int nchan);
+GuidedBilateralRowKernel GuidedBilateralSelectRowInterleavedAVX2(int demisize, int nchan);
+GuidedBilateralRowKernel GuidedBilateralSelectRowInterleavedAVX512(int demisize, int nchan);
+
+// Fused II + IJ row of the interleaved images: filters orig guided by guide into filteredIJ and guided by
+// orig itself into filteredII, sharing the neighborhood loads and the weight tables of the two filters.
+typedef int (*GuidedBilateralDualRowKernel)(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+											float const *swindow, float const *iweight, float const *gweight, float *filteredIJ, float *filteredII,
+											int j, int ibegin, int iend);
+
+GuidedBilateralDualRowKernel GuidedBilateralSelectRowDualSSE42(int demisize, int nchan);
+GuidedBilateralDualRowKernel GuidedBilateralSelectRowDualAVX2(int demisize, int nchan);
+GuidedBilateralDualRowKernel GuidedBilateralSelectRowDualAVX512(int demisize, int nchan);
+
+// Static weight planes of the dual filter. sweight[|k|] * sweight[|l|] * gweight of a neighbor, channel and filter
+// depends on the guides only: the steps that share sscale, gscale and gpower compute it once. F32 keeps the float
+// product, F16 stores it times 2^14 as a half float, U8 times 255 rounded. The products below the smallest normal
+// of the format are stored as 0.
+enum GuidedBilateralPrecision
+{
+	GBF_STATIC_NONE = 0,
+	GBF_STATIC_F32,
+	GBF_STATIC_F16,
+	GBF_STATIC_U8
+};
+
+#define GBF_HALF_SCALE 16384.0f
+// 2^112 / GBF_HALF_SCALE, undoes the exponent shift of fromhalf and the scale
+#define GBF_HALF_UNSCALE 3.16912650057057350374e29f
+
+// Dual row on static weights. The plane of the neighbor n = (k + demisize) * (2 * demisize + 1) + l + demisize,
+// the channel c and the filter f (0 IJ, 1 II) starts at ((n * nchan + c) * 2 + f) * dimx * dimy.
+typedef int (*GuidedBilateralDualStaticRowKernel)(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, int demisize,
+												  float const *iweight, void const *weights, float *filteredIJ, float *filteredII,
+												  int j, int ibegin, int iend);
+
+// Picks Row<Precision>::Kernel<Radius, NChan>::run like GuidedBilateralSelectRow
+template <template <int> class Row>
+GuidedBilateralDualStaticRowKernel GuidedBilateralSelectRowStatic(int demisize, int nchan, GuidedBilateralPrecision precision)
+{
+	switch (precision)
+	{
+	case GBF_STATIC_F16:
+		return GuidedBilateralSelectRow<Row<GBF_STATIC_F16>::template Kernel>(demisize, nchan);
+	case GBF_STATIC_U8:
+		return GuidedBilateralSelectRow<Row<GBF_STATIC_U8>::template Kernel>(demisize, nchan);
+	default:
+		return GuidedBilateralSelectRow<Row<GBF_STATIC_F32>::template Kernel>(demisize, nchan);
+	}
+}
+
+GuidedBilateralDualStaticRowKernel GuidedBilateralSelectRowDualStaticSSE42(int demisize, int nchan, GuidedBilateralPrecision precision);
+GuidedBilateralDualStaticRowKernel GuidedBilateralSelectRowDualStaticAVX2(int demisize, int nchan, GuidedBilateralPrecision precision);
+GuidedBilateralDualStaticRowKernel GuidedBilateralSelectRowDualStaticAVX512(int demisize, int nchan, GuidedBilateralPrecision precision);
+
+// bytes of the static weight planes, (2 * demisize + 1)^2 * nchan * 2 values per pixel
+size_t GuidedBilateralStaticBytes(int dimx, int dimy, int nchan, int demisize, GuidedBilateralPrecision precision);
+
+// maximum channel count of the interleaved variants
+#define GBF_MAX_NCHAN 4
+
+// GNC schedule of GuidedBilateralFilter: the parameters of its successive steps
+struct GuidedBilateralStepParams
+{
+	float sscale, iscale, ipower, gscale, gpower;
+};
+
+// fills steps and returns their count, at most GBF_MAX_STEPS
+#define GBF_MAX_STEPS 8
+int GuidedBilateralSchedule(float sscale, float iscale, float ipower, float gscale, float gpower, GuidedBilateralStepParams *steps);
+
+// weight tables of every step of the schedule, for the callers that filter many frames with the same parameters.
+// the steps from gnc on are the final iterations, they share the parameters of the last step. the tables are the
+// ones of the process wide cache of cpu_weights.h, the struct owns none of them and is cheap to copy.
+struct GuidedBilateralTables
+{
+	int demisize, num, gnc;
+	GuidedBilateralStepParams steps[GBF_MAX_STEPS];
+	float const *swindow[GBF_MAX_STEPS], *iweight[GBF_MAX_STEPS], *gweight[GBF_MAX_STEPS];
+};
+
+int GuidedBilateralBuildTables(int demisize, float sscale, float iscale, float ipower, float gscale, float gpower, GuidedBilateralTables *tables);
+void GuidedBilateralFreeTables(GuidedBilateralTables *tables);
+
+// The legacy filters of legacy/ as weight policies of the guided filter: the weight of a neighbor is always
+// iweight(|orig - filtered|) * sweight * gweight(|guide - guide center|), a policy only picks the tables and the steps,
+// and every kernel runs them. A unit table multiplies by exactly 1.0f, filtered starts at orig, so a single step
+// reads the intensity differences to the center in orig, integers that take iweight[d] exactly.
+// - GUIDED: guidedbilateralfilter_mex.c, the GNC schedule, GuidedBilateralBuildTables
+// - ROBUST: robustbilateralfilter_mex.c, the same schedule without guide, unit gweight
+// - BILATERAL: bilateralfilter_mex.c, one step, gaussian iweight of iscale, unit gweight
+// - JOINTCROSS: jointcrossbilateralfilter_mex.c, one step, unit iweight, gaussian gweight of gscale
+// The policies without guide weights read guide all the same, pass orig. The arguments a policy does not use are
+// ignored and left 0 in steps. The legacy sums start at 1e-6, those of the bilateral filter at 0: its gweight is
+// GBF_POLICY_SUM_SCALE, a power of 2 that keeps the ratios of the weights and leaves the 1e-6 below the last bit of
+// the sums, flat areas keep their level. The legacy code multiplies the spatial weights last, the results can still
+// differ from it by a level where a division lands on an integer. The static weight planes in f16 and u8 do not
+// hold the scaled weights, GuidedBilateralFilterDualScratch returns 0 for the bilateral policy with them.
+#define GBF_POLICY_SUM_SCALE 16777216.0f
+enum GuidedBilateralPolicy
+{
+	GBF_POLICY_GUIDED = 0,
+	GBF_POLICY_ROBUST,
+	GBF_POLICY_BILATERAL,
+	GBF_POLICY_JOINTCROSS
+};
+
+int GuidedBilateralBuildPolicyTables(GuidedBilateralPolicy policy, int demisize, float sscale, float iscale, float ipower, float gscale, float gpower,
+									 GuidedBilateralTables *tables);
+const char *GuidedBilateralPolicyName(GuidedBilateralPolicy policy);
+
+// Temporal blocking of the GuidedBilateralFilter functions: the image is cut in tiles whose pixels read and write
+// about this many bytes, and each tile runs every step of the schedule before the next one. 0 runs the steps one
+// after the other over the whole image. The result is the same either way.
+#define GBF_TILE_BYTES (256 * 1024)
+#define GBF_TILE_MIN_ROWS 4
+#define GBF_TILE_MAX_ROWS 256
+void GuidedBilateralSetTileBytes(int bytes);
+int GuidedBilateralGetTileBytes();
+
+// Hand out of the tiles to the threads. GBF_SCHEDULE_DYNAMIC gives the next tile to the first free thread.
+// GBF_SCHEDULE_BANDS gives every thread the same contiguous band of rows on every frame: the filter's first writes
+// place the pages of a band on the node of its thread, and with pinned threads they stay local frame after frame.
+enum GuidedBilateralTileSchedule
+{
+	GBF_SCHEDULE_DYNAMIC = 0,
+	GBF_SCHEDULE_BANDS
+};
+void GuidedBilateralSetTileSchedule(GuidedBilateralTileSchedule schedule);
+GuidedBilateralTileSchedule GuidedBilateralGetTileSchedule();
+
+// Thread pinning, linux only. The cpus are the union of the masks the threads of the team had before they were first
+// pinned, their OMP_PROC_BIND / OMP_PLACES places or the cpus of the process. CLOSE puts thread t on the t-th of
+// them, SPREAD spaces the threads evenly over them, across the sockets. NONE puts back the mask each thread had
+// before, and leaves threads that were not pinned to OMP_PROC_BIND / OMP_PLACES.
+enum GuidedBilateralAffinity
+{
+	GBF_AFFINITY_NONE = 0,
+	GBF_AFFINITY_CLOSE,
+	GBF_AFFINITY_SPREAD
+};
+// the masks of the threads before their pinning, by thread number, kept by the caller between pinnings
+struct GuidedBilateralThreadMasks
+{
+	std::vector<unsigned char> masks, saved;
+};
+// pins the threads of the next parallel regions of the calling thread, returns how many were pinned
+int GuidedBilateralPinThreads(GuidedBilateralAffinity affinity, GuidedBilateralThreadMasks *threadMasks);
+
+// Per step times of the filters called next from the calling thread, added to timing->steps while the frame of
+// timing records. The steps run inside the tiles, so a step's time is the thread time summed over the tiles.
+// NULL stops it, and it does nothing without GBF_TIMING.
+void GuidedBilateralSetStepTiming(GuidedBilateralTiming *timing);
+
+// Hardware counters of the steps of the filters called next from the calling thread, see cpu_counters.h.
+// NULL stops them, and it does nothing without GBF_PERF_COUNTERS.
+struct GuidedBilateralStepCounters;
+void GuidedBilateralSetStepCounters(GuidedBilateralStepCounters *counters);
+
+int GuidedBilateralFilterStep(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+							  float sscale, float iscale, float ipower, float gscale, float gpower, float *filtered);
+
+int GuidedBilateralFilter(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+						  float sscale, float iscale, float ipower, float gscale, float gpower, unsigned char *result);
+
+// GuidedBilateralFilter with prebuilt tables, those of a policy included
+int GuidedBilateralFilterTables(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide,
+								GuidedBilateralTables const *tables, unsigned char *result);
+
+// filtered holds nchan float planes of dimx * dimy, result is interleaved like orig
+int GuidedBilateralFilterStepInterleaved(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+										 float sscale, float iscale, float ipower, float gscale, float gpower, float *filtered);
+
+int GuidedBilateralFilterInterleaved(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+									 float sscale, float iscale, float ipower, float gscale, float gpower, unsigned char *result);
+
+// GuidedBilateralFilterInterleaved with prebuilt tables. each channel is guided by its own channel of guide, where the
+// planar joint / cross filter multiplies the guide weights of the ncol guide planes.
+int GuidedBilateralFilterInterleavedTables(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide,
+										   GuidedBilateralTables const *tables, unsigned char *result);
+
+// Both filters of the comparison at once, same results as GuidedBilateralFilterInterleaved(orig, guide) into
+// resultIJ and GuidedBilateralFilterInterleaved(orig, orig) into resultII.
+int GuidedBilateralFilterStepDual(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+								  float sscale, float iscale, float ipower, float gscale, float gpower, float *filteredIJ, float *filteredII);
+
+int GuidedBilateralFilterDual(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+							  float sscale, float iscale, float ipower, float gscale, float gpower, unsigned char *resultIJ, unsigned char *resultII);
+
+// Early termination of the final iterations: a segment of GBF_TRACK_SEGMENT pixels of a row leaves them once none
+// of its pixels moved by tolerance or more in the last one, in any channel of either filter. maxIterations > 0 caps
+// the final iterations. The warm-up steps always run, tolerance 0 and maxIterations 0 give the full schedule. The
+// tracking runs the tiled order, also when the tile size is 0. iterations and meanIterations return the steps run
+// by the slowest segment and by a pixel on average.
+#define GBF_TRACK_SEGMENT 16
+#define GBF_TRACK_MAX_SEGMENTS 4096
+struct GuidedBilateralConvergence
+{
+	float tolerance;
+	int maxIterations;
+	int iterations;
+	float meanIterations;
+};
+
+// Called from the worker threads once the results of the pixels [ibegin, iend) of the rows [jbegin, jend) are final,
+// to start the comparison of a part of the frame while the filter runs on the rest
+typedef void (*GuidedBilateralDoneCallback)(void *user, int jbegin, int jend, int ibegin, int iend);
+
+// Asked from the worker threads before the steps of a tile, the pixels [ibegin, iend) of the rows [jbegin, jend). A tile
+// the callback returns 1 for is left to it: its steps do not run, its results keep their bytes and done is not called.
+// The tiles are at most GBF_SCREEN_TILE pixels wide and high then.
+#define GBF_SCREEN_TILE 16
+typedef int (*GuidedBilateralSkipCallback)(void *user, int jbegin, int jend, int ibegin, int iend);
+
+// GuidedBilateralFilterDual with prebuilt tables and a scratch of 2 * nchan * dimx * dimy floats from the caller, allocates nothing.
+// The strides are the bytes between two rows of the images, dimx * nchan when contiguous: orig, guide and the results
+// can be views into larger images, they are read and written in place. convergence may be NULL for the full schedule.
+// With a precision, weights holds GuidedBilateralStaticBytes for the static weight planes, the steps that share their
+// guide and spatial parameters with another one run on them. done may be NULL, and skip, which shares user with done:
+// with it the steps run in tiles also when the tile size is 0.
+int GuidedBilateralFilterDualScratch(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride,
+									 GuidedBilateralTables const *tables, float *scratch, unsigned char *resultIJ, int resultIJStride,
+									 unsigned char *resultII, int resultIIStride, GuidedBilateralConvergence *convergence = NULL,
+									 GuidedBilateralPrecision precision = GBF_STATIC_NONE, void *weights = NULL,
+									 GuidedBilateralDoneCallback done = NULL, void *user = NULL, GuidedBilateralSkipCallback skip = NULL);
+
+// Pre-screen of the comparison of the two filters, returns 1 when |resultII - resultIJ| <= threshold is certain on every
+// pixel of the tile without filtering it. Every step averages orig over the window, so both results of a pixel lie
+// between the minimum and the maximum of orig over its window, a level below for the truncation: a channel whose orig
+// range over the tile and its demisize halo stays under threshold cannot exceed it. A channel whose guide is orig plus
+// a constant over the same area gives IJ the weights of II, the same bits. 0 when the tables can give the center of a
+// window a weight below GBF_SCREEN_MIN_WEIGHT, against which the 1e-6 of the sums is no longer negligible.
+#define GBF_SCREEN_MIN_WEIGHT 5e-4f
+int GuidedBilateralScreenTile(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride,
+							  GuidedBilateralTables const *tables, int threshold, int jbegin, int jend, int ibegin, int iend);
+
+// GuidedBilateralFilterDualScratch on the rows [top, top + rows) of a window of dimy rows, for the images streamed
+// strip by strip. A step reads its neighbors in orig and guide only, the rows of the window around the strip are the
+// halo of the whole schedule: demisize image rows above and below it, fewer where the image ends. The results are
+// those of the whole image, resultIJ and resultII hold the rows of the strip only. scratch holds 2 * nchan * dimx * dimy
+// floats. runs the whole schedule without static weights.
+int GuidedBilateralFilterDualStrip(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride,
+								   int top, int rows, GuidedBilateralTables const *tables, float *scratch,
+								   unsigned char *resultIJ, int resultIJStride, unsigned char *resultII, int resultIIStride);
+
+// Coarse to fine warm-up. The GNC steps before the final iterations only bring filtered into the basin of the
+// non-convex ones: GuidedBilateralFilterDualPyramid runs them on orig and guide reduced by 2^levels, box means of
+// the blocks, with the same tables, and upsamples their estimate bilinearly as the start of the final iterations
+// at full resolution. The warm-up costs 4^-levels of its full resolution work. The results are not those of
+// GuidedBilateralFilterDualScratch, guidedbilateral_cpu --verify reports the difference. levels 0 or a schedule
+// without warm-up steps runs GuidedBilateralFilterDualScratch. pyramid holds GuidedBilateralPyramidBytes, scratch
+// 2 * nchan * dimx * dimy floats. runs the whole schedule, without convergence tracking nor static weights.
+#define GBF_PYRAMID_MAX_LEVELS 4
+size_t GuidedBilateralPyramidBytes(int dimx, int dimy, int nchan, int levels);
+int GuidedBilateralFilterDualPyramid(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride,
+									 GuidedBilateralTables const *tables, int levels, float *scratch, void *pyramid,
+									 unsigned char *resultIJ, int resultIJStride, unsigned char *resultII, int resultIIStride,
+									 GuidedBilateralDoneCallback done = NULL, void *user = NULL);
+
+// One image pair of GuidedBilateralFilterDualBatch, dimx * dimy pixels of the nchan of the batch, the row strides in
+// bytes like GuidedBilateralFilterDualScratch. convergence may be NULL.
+struct GuidedBilateralPair
+{
+	int dimx, dimy;
+	unsigned char const *orig, *guide;
+	unsigned char *resultIJ, *resultII;
+	GuidedBilateralConvergence *convergence;
+	int origStride, guideStride, resultIJStride, resultIIStride;
+};
+
+// GuidedBilateralFilterDualScratch on count pairs sharing the tables. The tiles of all the pairs are the jobs of one
+// parallel loop, a batch of small images keeps every thread busy. scratch holds 2 * nchan * dimx * dimy floats per pair.
+int GuidedBilateralFilterDualBatch(int count, GuidedBilateralPair const *pairs, int nchan, GuidedBilateralTables const *tables, float *scratch);
+
+// Fixed point variant of GuidedBilateralFilterDual. filtered is kept as 8.8 unsigned shorts, the weights as Q15 integers
+// and the sums as int32. The intensity weight comes from a lut of the float interpolation every 1/16 level instead of
+// interpolating between two entries. Error bounds against the float path:
+// - per step, a weight is off by at most 2^-14 + slope(iweight) / 16, 0.004 for iscale 10, and filtered by 1/512 level
+// - after the default schedule, on document pairs, 1 to 6% of the 8 bit results differ by 1 level, less than 0.01% by
+//   more. the larger differences, up to 15 levels, are pixels where the float path itself flips between two modes.
+// The int32 sums limit demisize to 7.
+#define GBF_FIXED_ONE 32768
+#define GBF_FIXED_SHIFT 15
+#define GBF_FIXED_LUT_SHIFT 4
+#define GBF_FIXED_LUT_SIZE ((255 << (8 - GBF_FIXED_LUT_SHIFT)) + 1)
+#define GBF_FIXED_MAX_DEMISIZE 7
+
+static inline int GuidedBilateralFixed(float w)
+{
+	return (int)(w * (float)GBF_FIXED_ONE + 0.5f);
+}
+
+struct GuidedBilateralFixedTables
+{
+	int iweight[GBF_MAX_STEPS][GBF_FIXED_LUT_SIZE], gweight[GBF_MAX_STEPS][256];
+};
+
+// converts the float tables, fails for a demisize above GBF_FIXED_MAX_DEMISIZE
+int GuidedBilateralBuildFixedTables(GuidedBilateralTables const *tables, GuidedBilateralFixedTables *fixed);
+
+typedef int (*GuidedBilateralDualFixedRowKernel)(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+												 float const *swindow, int const *iweight, int const *gweight,
+												 unsigned short *filteredIJ, unsigned short *filteredII, int j, int ibegin, int iend);
+
+GuidedBilateralDualFixedRowKernel GuidedBilateralSelectRowDualFixedSSE42(int demisize, int nchan);
+GuidedBilateralDualFixedRowKernel GuidedBilateralSelectRowDualFixedAVX2(int demisize, int nchan);
+GuidedBilateralDualFixedRowKernel GuidedBilateralSelectRowDualFixedAVX512(int demisize, int nchan);
+
+// GuidedBilateralFilterDualScratch in fixed point, scratch holds 2 * nchan * dimx * dimy unsigned shorts. runs the whole
+// schedule, without convergence tracking nor static weights.
+int GuidedBilateralFilterDualFixedScratch(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride,
+										  GuidedBilateralTables const *tables, GuidedBilateralFixedTables const *fixed, unsigned short *scratch,
+										  unsigned char *resultIJ, int resultIJStride, unsigned char *resultII, int resultIIStride,
+										  GuidedBilateralDoneCallback done = NULL, void *user = NULL);
+
+#endif
@@ -0,0 +1,102 @@
+// compiled with -mavx2
+#include "cpu_filter.h"
+#include "cpu_filter_simd.h"
+
+#include <immintrin.h>
+
+struct VecAVX2
+{
+	typedef __m256 f;
+	typedef __m256i i;
+	enum { width = 8 };
+
+	static inline f set1(float x) { return _mm256_set1_ps(x); }
+	static inline f loadf(float const *p) { return _mm256_loadu_ps(p); }
+	static inline void storef(float *p, f x) { _mm256_storeu_ps(p, x); }
+	static inline i loadu8(unsigned char const *p) { return _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const *)p)); }
+	static inline i loadu16(unsigned short const *p) { return _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const *)p)); }
+	static inline i loadu8s(unsigned char const *p, int stride)
+	{
+		const __m256i index = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+		return _mm256_and_si256(_mm256_i32gather_epi32((int const *)p, index, 1), _mm256_set1_epi32(0xff));
+	}
+	// 8 pixels of 3 interleaved channels, reads exactly the 24 bytes with two overlapping 16 byte loads
+	static inline void loadu8x3(unsigned char const *p, i &c0, i &c1, i &c2)
+	{
+		const __m128i lo = _mm_loadu_si128((__m128i const *)p);
+		const __m128i hi = _mm_loadu_si128((__m128i const *)(p + 8));
+		c0 = _mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+											   _mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1))));
+		c1 = _mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+											   _mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1))));
+		c2 = _mm256_cvtepu8_epi32(_mm_or_si128(_mm_shuffle_epi8(lo, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+											   _mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1))));
+	}
+	static inline f tof(i x) { return _mm256_cvtepi32_ps(x); }
+	// bits of a half float moved to the float exponent and mantissa, the value is scaled by 2^-112
+	static inline f fromhalf(i h) { return _mm256_castsi256_ps(_mm256_slli_epi32(h, 13)); }
+	static inline i trunc(f x) { return _mm256_cvttps_epi32(x); }
+	static inline f add(f a, f b) { return _mm256_add_ps(a, b); }
+	static inline f sub(f a, f b) { return _mm256_sub_ps(a, b); }
+	static inline f mul(f a, f b) { return _mm256_mul_ps(a, b); }
+	static inline f div(f a, f b) { return _mm256_div_ps(a, b); }
+	static inline f absf(f x) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x); }
+	static inline i absdiff(i a, i b) { return _mm256_abs_epi32(_mm256_sub_epi32(a, b)); }
+	static inline i set1i(int x) { return _mm256_set1_epi32(x); }
+	static inline i addi(i a, i b) { return _mm256_add_epi32(a, b); }
+	static inline i mulloi(i a, i b) { return _mm256_mullo_epi32(a, b); }
+	static inline i maxi(i a, i b) { return _mm256_max_epi32(a, b); }
+	template <int n> static inline i srli(i x) { return _mm256_srli_epi32(x, n); }
+	template <int n> static inline i slli(i x) { return _mm256_slli_epi32(x, n); }
+	static inline i gatheri(int const *table, i index) { return _mm256_i32gather_epi32(table, index, 4); }
+	// the low 16 bits of the 8 lanes, values in [0, 65535]. packus works per 128 bit lane
+	static inline void storeu16(unsigned short *p, i x)
+	{
+		_mm_storeu_si128((__m128i *)p, _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi32(x, x), 0x08)));
+	}
+	static inline f gather(float const *table, i index) { return _mm256_i32gather_ps(table, index, 4); }
+};
+
+template <int Radius, int NCol>
+using RowAVX2 = GuidedBilateralRowSIMD<VecAVX2, Radius, NCol>;
+
+GuidedBilateralRowKernel GuidedBilateralSelectRowAVX2(int demisize, int ncol)
+{
+	return GuidedBilateralSelectRow<RowAVX2>(demisize, ncol);
+}
+
+template <int Radius, int NChan>
+using RowInterleavedAVX2 = GuidedBilateralRowSIMDInterleaved<VecAVX2, Radius, NChan>;
+
+GuidedBilateralRowKernel GuidedBilateralSelectRowInterleavedAVX2(int demisize, int nchan)
+{
+	return GuidedBilateralSelectRow<RowInterleavedAVX2>(demisize, nchan);
+}
+
+template <int Radius, int NChan>
+using RowDualAVX2 = GuidedBilateralRowSIMDDual<VecAVX2, Radius, NChan>;
+
+GuidedBilateralDualRowKernel GuidedBilateralSelectRowDualAVX2(int demisize, int nchan)
+{
+	return GuidedBilateralSelectRow<RowDualAVX2>(demisize, nchan);
+}
+
+template <int Precision>
+struct RowDualStaticAVX2
+{
+	template <int Radius, int NChan>
+	using Kernel = GuidedBilateralRowSIMDDualStatic<VecAVX2, Radius, NChan, Precision>;
+};
+
+GuidedBilateralDualStaticRowKernel GuidedBilateralSelectRowDualStaticAVX2(int demisize, int nchan, GuidedBilateralPrecision precision)
+{
+	return GuidedBilateralSelectRowStatic<RowDualStaticAVX2>(demisize, nchan, precision);
+}
+
+template <int Radius, int NChan>
+using RowDualFixedAVX2 = GuidedBilateralRowSIMDDualFixed<VecAVX2, Radius, NChan>;
+
+GuidedBilateralDualFixedRowKernel GuidedBilateralSelectRowDualFixedAVX2(int demisize, int nchan)
+{
+	return GuidedBilateralSelectRow<RowDualFixedAVX2>(demisize, nchan);
+}
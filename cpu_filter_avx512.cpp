@@ -0,0 +1,103 @@
+// compiled with -mavx512f
+#include "cpu_filter.h"
+#include "cpu_filter_simd.h"
+
+#include <immintrin.h>
+
+struct VecAVX512
+{
+	typedef __m512 f;
+	typedef __m512i i;
+	enum { width = 16 };
+
+	static inline f set1(float x) { return _mm512_set1_ps(x); }
+	static inline f loadf(float const *p) { return _mm512_loadu_ps(p); }
+	static inline void storef(float *p, f x) { _mm512_storeu_ps(p, x); }
+	static inline i loadu8(unsigned char const *p) { return _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i const *)p)); }
+	static inline i loadu16(unsigned short const *p) { return _mm512_cvtepu16_epi32(_mm256_loadu_si256((__m256i const *)p)); }
+	static inline i loadu8s(unsigned char const *p, int stride)
+	{
+		const __m512i index = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(stride));
+		return _mm512_and_si512(_mm512_i32gather_epi32(index, p, 1), _mm512_set1_epi32(0xff));
+	}
+	// 16 pixels of 3 interleaved channels, reads exactly the 48 bytes
+	static inline void loadu8x3(unsigned char const *p, i &c0, i &c1, i &c2)
+	{
+		const __m128i a = _mm_loadu_si128((__m128i const *)p);
+		const __m128i b = _mm_loadu_si128((__m128i const *)(p + 16));
+		const __m128i c = _mm_loadu_si128((__m128i const *)(p + 32));
+		c0 = _mm512_cvtepu8_epi32(_mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+															_mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+											   _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13))));
+		c1 = _mm512_cvtepu8_epi32(_mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+															_mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+											   _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14))));
+		c2 = _mm512_cvtepu8_epi32(_mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+															_mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+											   _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15))));
+	}
+	static inline f tof(i x) { return _mm512_cvtepi32_ps(x); }
+	// bits of a half float moved to the float exponent and mantissa, the value is scaled by 2^-112
+	static inline f fromhalf(i h) { return _mm512_castsi512_ps(_mm512_slli_epi32(h, 13)); }
+	static inline i trunc(f x) { return _mm512_cvttps_epi32(x); }
+	static inline f add(f a, f b) { return _mm512_add_ps(a, b); }
+	static inline f sub(f a, f b) { return _mm512_sub_ps(a, b); }
+	static inline f mul(f a, f b) { return _mm512_mul_ps(a, b); }
+	static inline f div(f a, f b) { return _mm512_div_ps(a, b); }
+	static inline f absf(f x) { return _mm512_abs_ps(x); }
+	static inline i absdiff(i a, i b) { return _mm512_abs_epi32(_mm512_sub_epi32(a, b)); }
+	static inline i set1i(int x) { return _mm512_set1_epi32(x); }
+	static inline i addi(i a, i b) { return _mm512_add_epi32(a, b); }
+	static inline i mulloi(i a, i b) { return _mm512_mullo_epi32(a, b); }
+	static inline i maxi(i a, i b) { return _mm512_max_epi32(a, b); }
+	template <int n> static inline i srli(i x) { return _mm512_srli_epi32(x, n); }
+	template <int n> static inline i slli(i x) { return _mm512_slli_epi32(x, n); }
+	static inline i gatheri(int const *table, i index) { return _mm512_i32gather_epi32(index, table, 4); }
+	// the low 16 bits of the 16 lanes, values in [0, 65535]
+	static inline void storeu16(unsigned short *p, i x) { _mm256_storeu_si256((__m256i *)p, _mm512_cvtepi32_epi16(x)); }
+	static inline f gather(float const *table, i index) { return _mm512_i32gather_ps(index, table, 4); }
+};
+
+template <int Radius, int NCol>
+using RowAVX512 = GuidedBilateralRowSIMD<VecAVX512, Radius, NCol>;
+
+GuidedBilateralRowKernel GuidedBilateralSelectRowAVX512(int demisize, int ncol)
+{
+	return GuidedBilateralSelectRow<RowAVX512>(demisize, ncol);
+}
+
+template <int Radius, int NChan>
+using RowInterleavedAVX512 = GuidedBilateralRowSIMDInterleaved<VecAVX512, Radius, NChan>;
+
+GuidedBilateralRowKernel GuidedBilateralSelectRowInterleavedAVX512(int demisize, int nchan)
+{
+	return GuidedBilateralSelectRow<RowInterleavedAVX512>(demisize, nchan);
+}
+
+template <int Radius, int NChan>
+using RowDualAVX512 = GuidedBilateralRowSIMDDual<VecAVX512, Radius, NChan>;
+
+GuidedBilateralDualRowKernel GuidedBilateralSelectRowDualAVX512(int demisize, int nchan)
+{
+	return GuidedBilateralSelectRow<RowDualAVX512>(demisize, nchan);
+}
+
+template <int Precision>
+struct RowDualStaticAVX512
+{
+	template <int Radius, int NChan>
+	using Kernel = GuidedBilateralRowSIMDDualStatic<VecAVX512, Radius, NChan, Precision>;
+};
+
+GuidedBilateralDualStaticRowKernel GuidedBilateralSelectRowDualStaticAVX512(int demisize, int nchan, GuidedBilateralPrecision precision)
+{
+	return GuidedBilateralSelectRowStatic<RowDualStaticAVX512>(demisize, nchan, precision);
+}
+
+template <int Radius, int NChan>
+using RowDualFixedAVX512 = GuidedBilateralRowSIMDDualFixed<VecAVX512, Radius, NChan>;
+
+GuidedBilateralDualFixedRowKernel GuidedBilateralSelectRowDualFixedAVX512(int demisize, int nchan)
+{
+	return GuidedBilateralSelectRow<RowDualFixedAVX512>(demisize, nchan);
+}
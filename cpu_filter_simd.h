@@ -0,0 +1,380 @@
+#ifndef CPU_FILTER_SIMD_H
+#define CPU_FILTER_SIMD_H
+
+// Vectorized row of GuidedBilateralFilterStep, shared by the sse4.2 / avx2 / avx512 translation units.
+// V wraps the intrinsics of one instruction set: V::width adjacent output pixels are filtered at once,
+// one per lane. The operations are the ones of the scalar loop, in the same order and without fma
+// contraction, so every lane gives the same float as GuidedBilateralFilterPixel.
+// Radius and NCol > 0 fix the window radius and the guide channel count at compile time, 0 reads them at runtime.
+
+template <class V, int Radius, int NCol>
+struct GuidedBilateralRowSIMD
+{
+	static int run(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+				   float const *swindow, float const *iweight, float const *gweight, float *filtered,
+				   int j, int ibegin, int iend)
+	{
+		typedef typename V::f vf;
+		typedef typename V::i vi;
+
+		const int r = Radius > 0 ? Radius : demisize;
+		const int nc = NCol > 0 ? NCol : ncol;
+		const int plane = dimx * dimy;
+		const vf one = V::set1(1.0f);
+		int i = ibegin;
+
+		for (; i + V::width <= iend; i += V::width)
+		{
+			vi currentGuide[3];
+			vf somme = V::set1(1e-6f);
+			vf pixelMoy = V::set1(0.0f);
+			vf currentIntensity = V::loadf(filtered + j * dimx + i);
+			currentGuide[0] = V::loadu8(guide + j * dimx + i);
+			if (nc == 3)
+			{
+				currentGuide[1] = V::loadu8(guide + plane + j * dimx + i);
+				currentGuide[2] = V::loadu8(guide + 2 * plane + j * dimx + i);
+			}
+
+			for (int k = -r; k <= r; k++)
+			{
+				const int row = (j + k) * dimx + i;
+				float const *sw = swindow + (k + r) * (2 * r + 1) + r;
+				for (int l = -r; l <= r; l++)
+				{
+					vf value = V::tof(V::loadu8(orig + row + l));
+					vf diff = V::absf(V::sub(value, currentIntensity));
+					vi ediff = V::trunc(diff);
+					vf rdiff = V::sub(diff, V::tof(ediff));
+					vf wguide = V::gather(gweight, V::absdiff(V::loadu8(guide + row + l), currentGuide[0]));
+					if (nc == 3)
+					{
+						wguide = V::mul(wguide, V::gather(gweight, V::absdiff(V::loadu8(guide + plane + row + l), currentGuide[1])));
+						wguide = V::mul(wguide, V::gather(gweight, V::absdiff(V::loadu8(guide + 2 * plane + row + l), currentGuide[2])));
+					}
+					vf interp = V::add(V::mul(V::sub(one, rdiff), V::gather(iweight, ediff)), V::mul(rdiff, V::gather(iweight + 1, ediff)));
+					vf poids = V::mul(V::mul(interp, V::set1(sw[l])), wguide);
+					somme = V::add(somme, poids);
+					pixelMoy = V::add(pixelMoy, V::mul(poids, value));
+				}
+			}
+
+			V::storef(filtered + j * dimx + i, V::div(pixelMoy, somme));
+		}
+
+		return i;
+	}
+};
+
+// Interleaved variant, every channel runs the operations of the planar kernel with ncol = 1.
+// Three channels are split with shuffles, other counts with strided gathers of 32 bit words which read
+// up to 3 bytes past the channel of the last lane: the caller keeps the last two pixels of the image out of the vectors.
+template <class V>
+static inline void GuidedBilateralLoadPixels(unsigned char const *p, int nc, typename V::i *channels)
+{
+	if (nc == 1)
+		channels[0] = V::loadu8(p);
+	else if (nc == 3)
+		V::loadu8x3(p, channels[0], channels[1], channels[2]);
+	else
+		for (int c = 0; c < nc; c++)
+			channels[c] = V::loadu8s(p + c, nc);
+}
+
+template <class V, int Radius, int NChan>
+struct GuidedBilateralRowSIMDInterleaved
+{
+	static int run(int dimx, int dimy, int nchan, unsigned char const *orig, unsigned char const *guide, int demisize,
+				   float const *swindow, float const *iweight, float const *gweight, float *filtered,
+				   int j, int ibegin, int iend)
+	{
+		typedef typename V::f vf;
+		typedef typename V::i vi;
+
+		const int r = Radius > 0 ? Radius : demisize;
+		const int nc = NChan > 0 ? NChan : nchan;
+		const int plane = dimx * dimy;
+		const vf one = V::set1(1.0f);
+		int i = ibegin;
+
+		for (; i + V::width <= iend; i += V::width)
+		{
+			vi currentGuide[GBF_MAX_NCHAN], values[GBF_MAX_NCHAN], guides[GBF_MAX_NCHAN];
+			vf somme[GBF_MAX_NCHAN], pixelMoy[GBF_MAX_NCHAN], currentIntensity[GBF_MAX_NCHAN];
+			GuidedBilateralLoadPixels<V>(guide + (j * dimx + i) * nc, nc, currentGuide);
+			for (int c = 0; c < nc; c++)
+			{
+				somme[c] = V::set1(1e-6f);
+				pixelMoy[c] = V::set1(0.0f);
+				currentIntensity[c] = V::loadf(filtered + c * plane + j * dimx + i);
+			}
+
+			for (int k = -r; k <= r; k++)
+			{
+				const int row = ((j + k) * dimx + i) * nc;
+				float const *sw = swindow + (k + r) * (2 * r + 1) + r;
+				for (int l = -r; l <= r; l++)
+				{
+					const vf spatial = V::set1(sw[l]);
+					GuidedBilateralLoadPixels<V>(orig + row + l * nc, nc, values);
+					GuidedBilateralLoadPixels<V>(guide + row + l * nc, nc, guides);
+					for (int c = 0; c < nc; c++)
+					{
+						vf value = V::tof(values[c]);
+						vf diff = V::absf(V::sub(value, currentIntensity[c]));
+						vi ediff = V::trunc(diff);
+						vf rdiff = V::sub(diff, V::tof(ediff));
+						vf wguide = V::gather(gweight, V::absdiff(guides[c], currentGuide[c]));
+						vf interp = V::add(V::mul(V::sub(one, rdiff), V::gather(iweight, ediff)), V::mul(rdiff, V::gather(iweight + 1, ediff)));
+						vf poids = V::mul(V::mul(interp, spatial), wguide);
+						somme[c] = V::add(somme[c], poids);
+						pixelMoy[c] = V::add(pixelMoy[c], V::mul(poids, value));
+					}
+				}
+			}
+
+			for (int c = 0; c < nc; c++)
+				V::storef(filtered + c * plane + j * dimx + i, V::div(pixelMoy[c], somme[c]));
+		}
+
+		return i;
+	}
+};
+
+// Fused II + IJ variant: both filters weight the same orig neighbors, the IJ one guided by guide and the II
+// one by orig. Each accumulator runs the operations of the interleaved kernel, only the loads are shared.
+template <class V, int Radius, int NChan>
+struct GuidedBilateralRowSIMDDual
+{
+	static int run(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+				   float const *swindow, float const *iweight, float const *gweight, float *filteredIJ, float *filteredII,
+				   int j, int ibegin, int iend)
+	{
+		typedef typename V::f vf;
+		typedef typename V::i vi;
+
+		const int r = Radius > 0 ? Radius : demisize;
+		const int nc = NChan > 0 ? NChan : nchan;
+		const int plane = dimx * dimy;
+		const vf one = V::set1(1.0f);
+		int i = ibegin;
+
+		for (; i + V::width <= iend; i += V::width)
+		{
+			vi currentGuide[GBF_MAX_NCHAN], currentOrig[GBF_MAX_NCHAN], values[GBF_MAX_NCHAN], guides[GBF_MAX_NCHAN];
+			vf sommeIJ[GBF_MAX_NCHAN], pixelMoyIJ[GBF_MAX_NCHAN], currentIJ[GBF_MAX_NCHAN];
+			vf sommeII[GBF_MAX_NCHAN], pixelMoyII[GBF_MAX_NCHAN], currentII[GBF_MAX_NCHAN];
+			GuidedBilateralLoadPixels<V>(guide + j * guideStride + i * nc, nc, currentGuide);
+			GuidedBilateralLoadPixels<V>(orig + j * origStride + i * nc, nc, currentOrig);
+			for (int c = 0; c < nc; c++)
+			{
+				sommeIJ[c] = sommeII[c] = V::set1(1e-6f);
+				pixelMoyIJ[c] = pixelMoyII[c] = V::set1(0.0f);
+				currentIJ[c] = V::loadf(filteredIJ + c * plane + j * dimx + i);
+				currentII[c] = V::loadf(filteredII + c * plane + j * dimx + i);
+			}
+
+			for (int k = -r; k <= r; k++)
+			{
+				unsigned char const *origRow = orig + (j + k) * origStride + i * nc;
+				unsigned char const *guideRow = guide + (j + k) * guideStride + i * nc;
+				float const *sw = swindow + (k + r) * (2 * r + 1) + r;
+				for (int l = -r; l <= r; l++)
+				{
+					const vf spatial = V::set1(sw[l]);
+					GuidedBilateralLoadPixels<V>(origRow + l * nc, nc, values);
+					GuidedBilateralLoadPixels<V>(guideRow + l * nc, nc, guides);
+					for (int c = 0; c < nc; c++)
+					{
+						vf value = V::tof(values[c]);
+
+						vf diff = V::absf(V::sub(value, currentIJ[c]));
+						vi ediff = V::trunc(diff);
+						vf rdiff = V::sub(diff, V::tof(ediff));
+						vf wguide = V::gather(gweight, V::absdiff(guides[c], currentGuide[c]));
+						vf interp = V::add(V::mul(V::sub(one, rdiff), V::gather(iweight, ediff)), V::mul(rdiff, V::gather(iweight + 1, ediff)));
+						vf poids = V::mul(V::mul(interp, spatial), wguide);
+						sommeIJ[c] = V::add(sommeIJ[c], poids);
+						pixelMoyIJ[c] = V::add(pixelMoyIJ[c], V::mul(poids, value));
+
+						diff = V::absf(V::sub(value, currentII[c]));
+						ediff = V::trunc(diff);
+						rdiff = V::sub(diff, V::tof(ediff));
+						wguide = V::gather(gweight, V::absdiff(values[c], currentOrig[c]));
+						interp = V::add(V::mul(V::sub(one, rdiff), V::gather(iweight, ediff)), V::mul(rdiff, V::gather(iweight + 1, ediff)));
+						poids = V::mul(V::mul(interp, spatial), wguide);
+						sommeII[c] = V::add(sommeII[c], poids);
+						pixelMoyII[c] = V::add(pixelMoyII[c], V::mul(poids, value));
+					}
+				}
+			}
+
+			for (int c = 0; c < nc; c++)
+			{
+				V::storef(filteredIJ + c * plane + j * dimx + i, V::div(pixelMoyIJ[c], sommeIJ[c]));
+				V::storef(filteredII + c * plane + j * dimx + i, V::div(pixelMoyII[c], sommeII[c]));
+			}
+		}
+
+		return i;
+	}
+};
+
+// V::width static weights of a plane, decoded to float like GuidedBilateralStaticWeight
+template <class V, int Precision>
+static inline typename V::f GuidedBilateralLoadWeights(void const *weights, size_t index)
+{
+	if (Precision == GBF_STATIC_F16)
+		return V::mul(V::fromhalf(V::loadu16((unsigned short const *)weights + index)), V::set1(GBF_HALF_UNSCALE));
+	else if (Precision == GBF_STATIC_U8)
+		return V::mul(V::tof(V::loadu8((unsigned char const *)weights + index)), V::set1(1.0f / 255.0f));
+	else
+		return V::loadf((float const *)weights + index);
+}
+
+// Dual row on static weight planes: the guide lookups and the spatial weight are replaced by one load per
+// neighbor, channel and filter, only the intensity weight is computed. Same operations as GuidedBilateralFilterPixelDualStatic.
+template <class V, int Radius, int NChan, int Precision>
+struct GuidedBilateralRowSIMDDualStatic
+{
+	static int run(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, int demisize,
+				   float const *iweight, void const *weights, float *filteredIJ, float *filteredII,
+				   int j, int ibegin, int iend)
+	{
+		typedef typename V::f vf;
+		typedef typename V::i vi;
+
+		const int r = Radius > 0 ? Radius : demisize;
+		const int nc = NChan > 0 ? NChan : nchan;
+		const size_t plane = (size_t)dimx * dimy;
+		const vf one = V::set1(1.0f);
+		int i = ibegin;
+
+		for (; i + V::width <= iend; i += V::width)
+		{
+			vi values[GBF_MAX_NCHAN];
+			vf sommeIJ[GBF_MAX_NCHAN], pixelMoyIJ[GBF_MAX_NCHAN], currentIJ[GBF_MAX_NCHAN];
+			vf sommeII[GBF_MAX_NCHAN], pixelMoyII[GBF_MAX_NCHAN], currentII[GBF_MAX_NCHAN];
+			for (int c = 0; c < nc; c++)
+			{
+				sommeIJ[c] = sommeII[c] = V::set1(1e-6f);
+				pixelMoyIJ[c] = pixelMoyII[c] = V::set1(0.0f);
+				currentIJ[c] = V::loadf(filteredIJ + c * plane + j * dimx + i);
+				currentII[c] = V::loadf(filteredII + c * plane + j * dimx + i);
+			}
+
+			size_t w = (size_t)j * dimx + i;
+			for (int k = -r; k <= r; k++)
+			{
+				unsigned char const *origRow = orig + (j + k) * origStride + i * nc;
+				for (int l = -r; l <= r; l++)
+				{
+					GuidedBilateralLoadPixels<V>(origRow + l * nc, nc, values);
+					for (int c = 0; c < nc; c++, w += 2 * plane)
+					{
+						vf value = V::tof(values[c]);
+
+						vf diff = V::absf(V::sub(value, currentIJ[c]));
+						vi ediff = V::trunc(diff);
+						vf rdiff = V::sub(diff, V::tof(ediff));
+						vf interp = V::add(V::mul(V::sub(one, rdiff), V::gather(iweight, ediff)), V::mul(rdiff, V::gather(iweight + 1, ediff)));
+						vf poids = V::mul(interp, GuidedBilateralLoadWeights<V, Precision>(weights, w));
+						sommeIJ[c] = V::add(sommeIJ[c], poids);
+						pixelMoyIJ[c] = V::add(pixelMoyIJ[c], V::mul(poids, value));
+
+						diff = V::absf(V::sub(value, currentII[c]));
+						ediff = V::trunc(diff);
+						rdiff = V::sub(diff, V::tof(ediff));
+						interp = V::add(V::mul(V::sub(one, rdiff), V::gather(iweight, ediff)), V::mul(rdiff, V::gather(iweight + 1, ediff)));
+						poids = V::mul(interp, GuidedBilateralLoadWeights<V, Precision>(weights, w + plane));
+						sommeII[c] = V::add(sommeII[c], poids);
+						pixelMoyII[c] = V::add(pixelMoyII[c], V::mul(poids, value));
+					}
+				}
+			}
+
+			for (int c = 0; c < nc; c++)
+			{
+				V::storef(filteredIJ + c * plane + j * dimx + i, V::div(pixelMoyIJ[c], sommeIJ[c]));
+				V::storef(filteredII + c * plane + j * dimx + i, V::div(pixelMoyII[c], sommeII[c]));
+			}
+		}
+
+		return i;
+	}
+};
+
+// GuidedBilateralRowSIMDDual in fixed point, same operations as GuidedBilateralFilterPixelDualFixed
+template <class V, int Radius, int NChan>
+struct GuidedBilateralRowSIMDDualFixed
+{
+	static int run(int dimx, int dimy, int nchan, unsigned char const *orig, int origStride, unsigned char const *guide, int guideStride, int demisize,
+				   float const *swindow, int const *iweight, int const *gweight,
+				   unsigned short *filteredIJ, unsigned short *filteredII, int j, int ibegin, int iend)
+	{
+		typedef typename V::f vf;
+		typedef typename V::i vi;
+
+		const int r = Radius > 0 ? Radius : demisize;
+		const int nc = NChan > 0 ? NChan : nchan;
+		const int plane = dimx * dimy;
+		int i = ibegin;
+
+		for (; i + V::width <= iend; i += V::width)
+		{
+			vi currentGuide[GBF_MAX_NCHAN], currentOrig[GBF_MAX_NCHAN], values[GBF_MAX_NCHAN], guides[GBF_MAX_NCHAN];
+			vi sommeIJ[GBF_MAX_NCHAN], pixelMoyIJ[GBF_MAX_NCHAN], currentIJ[GBF_MAX_NCHAN];
+			vi sommeII[GBF_MAX_NCHAN], pixelMoyII[GBF_MAX_NCHAN], currentII[GBF_MAX_NCHAN];
+			GuidedBilateralLoadPixels<V>(guide + j * guideStride + i * nc, nc, currentGuide);
+			GuidedBilateralLoadPixels<V>(orig + j * origStride + i * nc, nc, currentOrig);
+			for (int c = 0; c < nc; c++)
+			{
+				sommeIJ[c] = sommeII[c] = pixelMoyIJ[c] = pixelMoyII[c] = V::set1i(0);
+				currentIJ[c] = V::loadu16(filteredIJ + c * plane + j * dimx + i);
+				currentII[c] = V::loadu16(filteredII + c * plane + j * dimx + i);
+			}
+
+			for (int k = -r; k <= r; k++)
+			{
+				unsigned char const *origRow = orig + (j + k) * origStride + i * nc;
+				unsigned char const *guideRow = guide + (j + k) * guideStride + i * nc;
+				float const *sw = swindow + (k + r) * (2 * r + 1) + r;
+				for (int l = -r; l <= r; l++)
+				{
+					const vi spatial = V::set1i(GuidedBilateralFixed(sw[l]));
+					GuidedBilateralLoadPixels<V>(origRow + l * nc, nc, values);
+					GuidedBilateralLoadPixels<V>(guideRow + l * nc, nc, guides);
+					for (int c = 0; c < nc; c++)
+					{
+						const vi value = V::template slli<8>(values[c]);
+
+						vi interp = V::gatheri(iweight, V::template srli<GBF_FIXED_LUT_SHIFT>(V::absdiff(value, currentIJ[c])));
+						vi wguide = V::gatheri(gweight, V::absdiff(guides[c], currentGuide[c]));
+						vi poids = V::template srli<GBF_FIXED_SHIFT>(V::mulloi(interp, V::template srli<GBF_FIXED_SHIFT>(V::mulloi(spatial, wguide))));
+						sommeIJ[c] = V::addi(sommeIJ[c], poids);
+						pixelMoyIJ[c] = V::addi(pixelMoyIJ[c], V::mulloi(poids, values[c]));
+
+						interp = V::gatheri(iweight, V::template srli<GBF_FIXED_LUT_SHIFT>(V::absdiff(value, currentII[c])));
+						wguide = V::gatheri(gweight, V::absdiff(values[c], currentOrig[c]));
+						poids = V::template srli<GBF_FIXED_SHIFT>(V::mulloi(interp, V::template srli<GBF_FIXED_SHIFT>(V::mulloi(spatial, wguide))));
+						sommeII[c] = V::addi(sommeII[c], poids);
+						pixelMoyII[c] = V::addi(pixelMoyII[c], V::mulloi(poids, values[c]));
+					}
+				}
+			}
+
+			// 8.8 result rounded, the sum of weights is at least 1 like the 1e-6 of the float path
+			const vf scale = V::set1(256.0f), half = V::set1(0.5f);
+			const vi least = V::set1i(1);
+			for (int c = 0; c < nc; c++)
+			{
+				V::storeu16(filteredIJ + c * plane + j * dimx + i, V::trunc(V::add(V::div(V::mul(V::tof(pixelMoyIJ[c]), scale), V::tof(V::maxi(sommeIJ[c], least))), half)));
+				V::storeu16(filteredII + c * plane + j * dimx + i, V::trunc(V::add(V::div(V::mul(V::tof(pixelMoyII[c]), scale), V::tof(V::maxi(sommeII[c], least))), half)));
+			}
+		}
+
+		return i;
+	}
+};
+
+#endif
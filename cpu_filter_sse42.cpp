@@ -0,0 +1,111 @@
+// compiled with -msse4.2
+#include "cpu_filter.h"
+#include "cpu_filter_simd.h"
+
+#include <string.h>
+#include <nmmintrin.h>
+
+struct VecSSE42
+{
+	typedef __m128 f;
+	typedef __m128i i;
+	enum { width = 4 };
+
+	static inline f set1(float x) { return _mm_set1_ps(x); }
+	static inline f loadf(float const *p) { return _mm_loadu_ps(p); }
+	static inline void storef(float *p, f x) { _mm_storeu_ps(p, x); }
+	static inline i loadu8(unsigned char const *p)
+	{
+		int bytes;
+		memcpy(&bytes, p, sizeof(bytes));
+		return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+	}
+	static inline i loadu16(unsigned short const *p) { return _mm_cvtepu16_epi32(_mm_loadl_epi64((__m128i const *)p)); }
+	static inline i loadu8s(unsigned char const *p, int stride)
+	{
+		return _mm_setr_epi32(p[0], p[stride], p[2 * stride], p[3 * stride]);
+	}
+	// 4 pixels of 3 interleaved channels, reads exactly the 12 bytes
+	static inline void loadu8x3(unsigned char const *p, i &c0, i &c1, i &c2)
+	{
+		int last;
+		memcpy(&last, p + 8, sizeof(last));
+		const __m128i bytes = _mm_unpacklo_epi64(_mm_loadl_epi64((__m128i const *)p), _mm_cvtsi32_si128(last));
+		c0 = _mm_cvtepu8_epi32(_mm_shuffle_epi8(bytes, _mm_setr_epi8(0, 3, 6, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)));
+		c1 = _mm_cvtepu8_epi32(_mm_shuffle_epi8(bytes, _mm_setr_epi8(1, 4, 7, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)));
+		c2 = _mm_cvtepu8_epi32(_mm_shuffle_epi8(bytes, _mm_setr_epi8(2, 5, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)));
+	}
+	static inline f tof(i x) { return _mm_cvtepi32_ps(x); }
+	// bits of a half float moved to the float exponent and mantissa, the value is scaled by 2^-112
+	static inline f fromhalf(i h) { return _mm_castsi128_ps(_mm_slli_epi32(h, 13)); }
+	static inline i trunc(f x) { return _mm_cvttps_epi32(x); }
+	static inline f add(f a, f b) { return _mm_add_ps(a, b); }
+	static inline f sub(f a, f b) { return _mm_sub_ps(a, b); }
+	static inline f mul(f a, f b) { return _mm_mul_ps(a, b); }
+	static inline f div(f a, f b) { return _mm_div_ps(a, b); }
+	static inline f absf(f x) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), x); }
+	static inline i absdiff(i a, i b) { return _mm_abs_epi32(_mm_sub_epi32(a, b)); }
+	// no gather instruction before avx2
+	static inline i set1i(int x) { return _mm_set1_epi32(x); }
+	static inline i addi(i a, i b) { return _mm_add_epi32(a, b); }
+	static inline i mulloi(i a, i b) { return _mm_mullo_epi32(a, b); }
+	static inline i maxi(i a, i b) { return _mm_max_epi32(a, b); }
+	template <int n> static inline i srli(i x) { return _mm_srli_epi32(x, n); }
+	template <int n> static inline i slli(i x) { return _mm_slli_epi32(x, n); }
+	static inline i gatheri(int const *table, i index)
+	{
+		return _mm_setr_epi32(table[_mm_extract_epi32(index, 0)], table[_mm_extract_epi32(index, 1)],
+							  table[_mm_extract_epi32(index, 2)], table[_mm_extract_epi32(index, 3)]);
+	}
+	// the low 16 bits of the 4 lanes, values in [0, 65535]
+	static inline void storeu16(unsigned short *p, i x) { _mm_storel_epi64((__m128i *)p, _mm_packus_epi32(x, x)); }
+	static inline f gather(float const *table, i index)
+	{
+		return _mm_setr_ps(table[_mm_extract_epi32(index, 0)], table[_mm_extract_epi32(index, 1)],
+						   table[_mm_extract_epi32(index, 2)], table[_mm_extract_epi32(index, 3)]);
+	}
+};
+
+template <int Radius, int NCol>
+using RowSSE42 = GuidedBilateralRowSIMD<VecSSE42, Radius, NCol>;
+
+GuidedBilateralRowKernel GuidedBilateralSelectRowSSE42(int demisize, int ncol)
+{
+	return GuidedBilateralSelectRow<RowSSE42>(demisize, ncol);
+}
+
+template <int Radius, int NChan>
+using RowInterleavedSSE42 = GuidedBilateralRowSIMDInterleaved<VecSSE42, Radius, NChan>;
+
+GuidedBilateralRowKernel GuidedBilateralSelectRowInterleavedSSE42(int demisize, int nchan)
+{
+	return GuidedBilateralSelectRow<RowInterleavedSSE42>(demisize, nchan);
+}
+
+template <int Radius, int NChan>
+using RowDualSSE42 = GuidedBilateralRowSIMDDual<VecSSE42, Radius, NChan>;
+
+GuidedBilateralDualRowKernel GuidedBilateralSelectRowDualSSE42(int demisize, int nchan)
+{
+	return GuidedBilateralSelectRow<RowDualSSE42>(demisize, nchan);
+}
+
+template <int Precision>
+struct RowDualStaticSSE42
+{
+	template <int Radius, int NChan>
+	using Kernel = GuidedBilateralRowSIMDDualStatic<VecSSE42, Radius, NChan, Precision>;
+};
+
+GuidedBilateralDualStaticRowKernel GuidedBilateralSelectRowDualStaticSSE42(int demisize, int nchan, GuidedBilateralPrecision precision)
+{
+	return GuidedBilateralSelectRowStatic<RowDualStaticSSE42>(demisize, nchan, precision);
+}
+
+template <int Radius, int NChan>
+using RowDualFixedSSE42 = GuidedBilateralRowSIMDDualFixed<VecSSE42, Radius, NChan>;
+
+GuidedBilateralDualFixedRowKernel GuidedBilateralSelectRowDualFixedSSE42(int demisize, int nchan)
+{
+	return GuidedBilateralSelectRow<RowDualFixedSSE42>(demisize, nchan);
+}
@@ -4,232 +4,150 @@
 #include <opencv2/imgproc.hpp>
 
 #include <iostream>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <chrono>
 #include <omp.h>
 
-int GuidedBilateralFilterStep(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
-							  float sscale, float iscale, float ipower, float gscale, float gpower, float *filtered)
-{
-	float *sweight = NULL, iweight[257], gweight[256];
-
-	/* spatial weight */
-	if ((sweight = (float *)malloc((demisize + 1) * sizeof(float))) == NULL)
-		return (0);
-	for (int i = 0; i <= demisize; i++)
-	{
-		if (sscale > 0.0f)
-			sweight[i] = exp(-0.5f * (float)(i * i) / (sscale * sscale));
-		else
-			sweight[i] = 1.0f;
-	}
-
-	/* intensity weight */
-	for (int i = 0; i <= 256; i++)
-	{
-		if (ipower != 1.0f)
-			iweight[i] = pow(1.0f + (float)(i * i) / (iscale * iscale), ipower - 1.0f);
-		else
-			iweight[i] = 1.0f;
-	}
-
-	/* guide weight */
-	for (int i = 0; i <= 255; i++)
-	{
-		if (gpower != 0.0f)
-			gweight[i] = exp(-(pow(1.0f + (float)(i * i) / (gscale * gscale), gpower) - 1.0f) / gpower);
-		else
-			gweight[i] = 1.0f / (1.0f + (float)(i * i) / (gscale * gscale));
-	}
-
-	// this loop is the slow part
-	#pragma omp parallel for collapse(2)
-	for (int j = 0; j < dimy; j++)
-	{
-		for (int i = 0; i < dimx; i++)
-		{
-			int value, ediff, currentGuide[3], diffGuide;
-			float wguide, somme, poids, pixelMoy, currentIntensity, diff, rdiff;
-			somme = 1e-6f;
-			pixelMoy = 0.0f;
-			currentIntensity = filtered[j * dimx + i];
-			currentGuide[0] = guide[j * dimx + i];
-			if (ncol == 3)
-			{
-				currentGuide[1] = guide[dimx * dimy + j * dimx + i];
-				currentGuide[2] = guide[2 * dimx * dimy + j * dimx + i];
-			}
-
-			for (int k = -demisize; k <= demisize; k++)
-			{
-				if ((j + k >= 0) && (j + k < dimy))
-				{
-					for (int l = -demisize; l <= demisize; l++)
-					{
-						if ((i + l >= 0) && (i + l < dimx))
-						{
-							value = orig[(j + k) * dimx + i + l];
-							diff = fabs((float)value - currentIntensity);
-							ediff = (int)floor(diff);
-							rdiff = diff - (float)ediff;
-							diffGuide = abs(guide[(j + k) * dimx + i + l] - currentGuide[0]);
-							wguide = gweight[diffGuide];
-							if (ncol == 3)
-							{
-								diffGuide = abs(guide[dimx * dimy + (j + k) * dimx + i + l] - currentGuide[1]);
-								wguide *= gweight[diffGuide];
-								diffGuide = abs(guide[2 * dimx * dimy + (j + k) * dimx + i + l] - currentGuide[2]);
-								wguide *= gweight[diffGuide];
-							}
-							poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * sweight[abs(k)] * sweight[abs(l)] * wguide;
-							somme += poids;
-							pixelMoy += poids * (float)value;
-						}
-					}
-				}
-			}
-
-			filtered[j * dimx + i] = pixelMoy / somme;
-		}
-	}
-
-	free(sweight);
-
-	return (1);
-}
-
-int GuidedBilateralFilter(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize, float sscale, float iscale, float ipower, float gscale, float gpower, unsigned char *result)
-{
-	int i, num = 8;
-
-	/* alloc */
-	float *filtered = new float[dimx * dimy];
-
-	/* init image */
-	for (i = 0; i < dimx * dimy; i++)
-		filtered[i] = (float)(orig[i]);
-
-	/* GNC */
-	if (ipower <= 1.0f)
-	{
-		if (!GuidedBilateralFilterStep(dimx, dimy, ncol, orig, guide, demisize, 0.0, iscale, 1.0, gscale * 5.0, gpower, filtered))
-			return (0);
-		num--;
-	}
-
-	if (ipower <= 0.5f)
-	{
-		if (!GuidedBilateralFilterStep(dimx, dimy, ncol, orig, guide, demisize, sscale, iscale, 0.5, gscale, gpower, filtered))
-			return (0);
-		num--;
-	}
-
-	if (ipower <= 0.0f)
-	{
-		if (!GuidedBilateralFilterStep(dimx, dimy, ncol, orig, guide, demisize, sscale, iscale, 0.0, gscale, gpower, filtered))
-			return (0);
-		num--;
-	}
-
-	/* final */
-	for (i = 0; i < num; i++)
-	{
-		if (!GuidedBilateralFilterStep(dimx, dimy, ncol, orig, guide, demisize, sscale, iscale, ipower, gscale, gpower, filtered))
-			return (0);
-	}
-
-	for (i = 0; i < dimx * dimy; i++)
-		result[i] = (unsigned char)(filtered[i]);
-
-	delete[] filtered;
-
-	return (1);
-}
+#include "cpu_engine.h"
+#include "cpu_verify.h"
+#include "cpu_stream.h"
+#include "cpu_weights.h"
 
 // very slow implementation, to improve
 // - use cv::cuda functions
-// - do not split and merge the color channels, change the above functions for the images with stacked color channels
 // - filter is parallelizable, implement it as a cuda plugin
 // - decrease the iteration count num = 8 in GuidedBilateralFilter()
 
 // i tried to add cpu multithreading. 647ms in karagag server.
+// one frame, GuidedBilateralFilterCPU keeps its buffers for a stream of frames
 cv::Mat GuidedBilateralFilterToCVImage(cv::Mat origimg_, cv::Mat guideimg_){
-	// Guided Bilateral Filter parameters
-	int hwsize = 2;
-	float sscale = 1.5f, iscale = 10.0f, ipower = 0.0f, gscale = 10.0f, gpower = 1.0f;
-
-	// Threshold parameter
-	int threshold = 80;
-
-	// Opening parameters
-	int morph_size = 1;
-	cv::Mat element = getStructuringElement(
-		cv::MORPH_ELLIPSE,
-		cv::Size(2 * morph_size + 1,
-					2 * morph_size + 1),
-		cv::Point(morph_size,
-					morph_size));
-
-
-	omp_set_num_threads(32);
+	GuidedBilateralFilterCPU gbFilter(origimg_.rows, origimg_.cols, origimg_.channels());
 
 	// cv::imshow("orig", origimg_);
 	// cv::imshow("guide", guideimg_);
 
-	cv::Mat origimg[3], guideimg[3];
-	cv::split(origimg_, origimg);
-	cv::split(guideimg_, guideimg);
+	// the mask keeps the engine's buffer alive
+	return gbFilter.Execute(origimg_, guideimg_);
+}
 
-	std::vector<cv::Mat> resultmatIIminusIJ;
-	resultmatIIminusIJ.reserve(3);
+// the input images of --verify, cmake passes the source tree's directory
+#ifndef GBF_INPUT_DIR
+#define GBF_INPUT_DIR "../input_images"
+#endif
 
-	// bgr color channels loop
-	// TODO: i tried to parallize here, but could not
-	for (int i = 0; i < 3; i++)
+// --verify: every variant of every kernel against the legacy filter, on random pairs and on the input images.
+// exits with 1 if one is outside its tolerance or an input pair is missing.
+static int GuidedBilateralVerifyMain()
+{
+	static const char *const pairs[][2] = {{"makale_1.png", "makale_0.png"},
+										   {"article1.png", "article0.png"},
+										   {"peppers.ppm", "peppers-Guide.ppm"},
+										   {"hudson_diatomE.pgm", "hudson_diatomE-Guide.pgm"}};
+	const GuidedBilateralVerifyParams params = {2, 1.5f, 10.0f, 0.0f, 10.0f, 1.0f};
+
+	int failures = GuidedBilateralVerifyRandom(stdout, 1);
+	// the constexpr tables of the default schedule against the formulas they were generated from
+	const int tables = GuidedBilateralCheckDefaultWeights(stdout);
+	printf("%-28s %-8s %-18s %d tables differ %s\n", "cpu_weights_default.h", "", "weights", tables, tables ? "FAIL" : "ok");
+	failures += tables;
+	for (auto &pair : pairs)
 	{
-		unsigned char * resultIJ = new unsigned char[origimg[i].rows * origimg[i].cols];
-		unsigned char * resultII = new unsigned char[origimg[i].rows * origimg[i].cols];
-
-		GuidedBilateralFilter(origimg[i].rows, origimg[i].cols, origimg[i].channels(), origimg[i].data, guideimg[i].data, hwsize, sscale, iscale, ipower, gscale, gpower, resultIJ);
-		cv::Mat resultmatIJ = cv::Mat(origimg[i].rows, origimg[i].cols, CV_8U, resultIJ);
-
-		GuidedBilateralFilter(origimg[i].rows, origimg[i].cols, origimg[i].channels(), origimg[i].data, origimg[i].data, hwsize, sscale, iscale, ipower, gscale, gpower, resultII);
-		cv::Mat resultmatII = cv::Mat(origimg[i].rows, origimg[i].cols, CV_8U, resultII);
-
-		cv::Mat resultmatIIminusIJ_channel;
-		cv::absdiff(resultmatII, resultmatIJ, resultmatIIminusIJ_channel);
+		const std::string origname = std::string(GBF_INPUT_DIR) + "/" + pair[0], guidename = std::string(GBF_INPUT_DIR) + "/" + pair[1];
+		cv::Mat origimg_ = cv::imread(origname, cv::IMREAD_UNCHANGED);
+		cv::Mat guideimg_ = cv::imread(guidename, cv::IMREAD_UNCHANGED);
+		if (origimg_.empty() || guideimg_.empty() || origimg_.rows != guideimg_.rows || origimg_.cols != guideimg_.cols ||
+			origimg_.type() != guideimg_.type() || origimg_.depth() != CV_8U)
+		{
+			// a missing input would pass the check without running it
+			printf("%-28s %-8s %-18s missing or mismatched pair FAIL\n", pair[0], "", "input");
+			failures++;
+			continue;
+		}
+		failures += GuidedBilateralVerifyPair(stdout, pair[0], origimg_.cols, origimg_.rows, origimg_.channels(), origimg_.data, guideimg_.data, params);
+
+		// the fused absdiff, threshold and opening of the engine against the opencv chain on its filter results
+		GuidedBilateralFilterCPU engine(origimg_.rows, origimg_.cols, origimg_.channels());
+		cv::Mat mask = engine.Execute(origimg_, guideimg_), reference;
+		cv::absdiff(engine.resultmatII, engine.resultmatIJ, reference);
+		cv::threshold(reference, reference, engine.threshold, 255, 1);
+		cv::morphologyEx(reference, reference, cv::MORPH_OPEN, engine.element, cv::Point(-1, -1), 2);
+		const int differ = cv::countNonZero(mask.reshape(1) != reference.reshape(1));
+		printf("%-28s %-8s %-18s %d pixels differ %s\n", pair[0], "", "mask", differ, differ ? "FAIL" : "ok");
+		failures += differ != 0;
+	}
 
-		cv::threshold(resultmatIIminusIJ_channel, resultmatIIminusIJ_channel, threshold, 255, 1);
+	printf("%d failures\n", failures);
+	return failures ? 1 : 0;
+}
 
-		morphologyEx(resultmatIIminusIJ_channel, resultmatIIminusIJ_channel,
-					 cv::MORPH_OPEN, element,
-					 cv::Point(-1, -1), 2);
+// --stream orig guide resultIJ [resultII [strip rows]]: the filter of a pgm / ppm pair too large for memory, strip by strip
+static int GuidedBilateralStreamMain(int argc, char **argv)
+{
+	GuidedBilateralStreamImage orig, guide, resultIJ, resultII;
+	GuidedBilateralTables tables;
+	int stripRows = argc > 4 ? atoi(argv[4]) : 256;
 
-		resultmatIIminusIJ.emplace_back(resultmatIIminusIJ_channel);
-			
-		// cv::imshow("resIJ channel:" + std::to_string(i), resultmatIJ);
-		// cv::imshow("resII channel:" + std::to_string(i), resultmatII);
-		// cv::imshow("distance channel:" + std::to_string(i), resultmatIIminusIJ_channel);
+	if (argc < 3)
+	{
+		printf("usage: guidedbilateral_cpu --stream orig guide resultIJ [resultII [strip rows]]\n");
+		return 1;
 	}
+	if (!GuidedBilateralStreamOpen(argv[0], &orig) || !GuidedBilateralStreamOpen(argv[1], &guide))
+	{
+		printf("%s, %s: not a binary pgm / ppm pair\n", argv[0], argv[1]);
+		return 1;
+	}
+	resultII.file = NULL;
+	if (!GuidedBilateralStreamCreate(argv[2], orig.dimx, orig.dimy, orig.nchan, &resultIJ) ||
+		(argc > 3 && !GuidedBilateralStreamCreate(argv[3], orig.dimx, orig.dimy, orig.nchan, &resultII)))
+	{
+		printf("cannot create the results\n");
+		return 1;
+	}
+	if (!GuidedBilateralBuildTables(2, 1.5f, 10.0f, 0.0f, 10.0f, 1.0f, &tables))
+		return 1;
+	// GuidedBilateralStreamFilter clamps the strips to the image, the report and the bytes are those of the clamped ones
+	if (stripRows > orig.dimy)
+		stripRows = orig.dimy;
 
-	cv::Mat mergedresultmatIIminusIJ;
-	merge(resultmatIIminusIJ, mergedresultmatIIminusIJ);
-	return mergedresultmatIIminusIJ;
+	auto start = std::chrono::steady_clock::now();
+	int ok = GuidedBilateralStreamFilter(&orig, &guide, &tables, stripRows, &resultIJ, argc > 3 ? &resultII : NULL);
+	auto end = std::chrono::steady_clock::now();
+	printf("%dx%dx%d in strips of %d rows, %zu bytes: %s in %lld ms\n", orig.dimx, orig.dimy, orig.nchan, stripRows,
+		   GuidedBilateralStreamBytes(orig.dimx, orig.nchan, tables.demisize, stripRows), ok ? "done" : "failed",
+		   (long long)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+
+	GuidedBilateralFreeTables(&tables);
+	GuidedBilateralStreamClose(&orig);
+	GuidedBilateralStreamClose(&guide);
+	GuidedBilateralStreamClose(&resultIJ);
+	GuidedBilateralStreamClose(&resultII);
+	return ok ? 0 : 1;
 }
 
-int main()
+int main(int argc, char **argv)
 {
+	if (argc > 1 && strcmp(argv[1], "--verify") == 0)
+		return GuidedBilateralVerifyMain();
+	if (argc > 1 && strcmp(argv[1], "--stream") == 0)
+		return GuidedBilateralStreamMain(argc - 2, argv + 2);
+
 	cv::Mat origimg_ = cv::imread("../input_images/makale_1.png", cv::IMREAD_COLOR);
 	origimg_.convertTo(origimg_, CV_8U); // just for safety
 	cv::Mat guideimg_ = cv::imread("../input_images/makale_0.png", cv::IMREAD_COLOR);
 	guideimg_.convertTo(guideimg_, CV_8U); // just for safety
 
+	GuidedBilateralFilterCPU gbFilter(origimg_.rows, origimg_.cols, origimg_.channels());
+	// GBF_TIMING_JSON=timing.jsonl writes the stage times of every frame, with a -DGBF_TIMING=ON build
+	GuidedBilateralTimingFromEnv();
+
 	int n_iter = 1;
 	auto start = std::chrono::steady_clock::now();
 	cv::Mat result;
 	for(int i = 0; i < n_iter; i++)
-	result = GuidedBilateralFilterToCVImage(origimg_, guideimg_);    
+	result = gbFilter.Execute(origimg_, guideimg_);    
     auto end = std::chrono::steady_clock::now();
     std::cout << "Elapsed time in milliseconds: "
         << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()/n_iter
@@ -0,0 +1,179 @@
+#include "cpu_mask.h"
+#include "cpu_filter.h"
+
+#include <string.h>
+#include <new>
+
+// rows of the block buffers, the block and the halo of the first erosion
+#define GBF_MASK_SPAN (GBF_MASK_BLOCK + 2 * (GBF_MASK_HALO - 1))
+
+void GuidedBilateralMaskInit(GuidedBilateralMask *pass)
+{
+	pass->pending = NULL;
+	pass->capacity = 0;
+	pass->nblockx = pass->nblocky = 0;
+}
+
+void GuidedBilateralMaskFree(GuidedBilateralMask *pass)
+{
+	delete[] pass->pending;
+	GuidedBilateralMaskInit(pass);
+}
+
+static inline int GuidedBilateralClamp(int x, int low, int high)
+{
+	return x < low ? low : x > high ? high : x;
+}
+
+// area of the block b and its halo inside the image
+static int GuidedBilateralBlockArea(const GuidedBilateralMask *pass, int b, int ibegin, int iend, int jbegin, int jend)
+{
+	const int bx = (b % pass->nblockx) * GBF_MASK_BLOCK, by = (b / pass->nblockx) * GBF_MASK_BLOCK;
+	const int x0 = GuidedBilateralClamp(bx - GBF_MASK_HALO, ibegin, iend), x1 = GuidedBilateralClamp(bx + GBF_MASK_BLOCK + GBF_MASK_HALO, ibegin, iend);
+	const int y0 = GuidedBilateralClamp(by - GBF_MASK_HALO, jbegin, jend), y1 = GuidedBilateralClamp(by + GBF_MASK_BLOCK + GBF_MASK_HALO, jbegin, jend);
+	return (x1 - x0) * (y1 - y0);
+}
+
+int GuidedBilateralMaskBegin(GuidedBilateralMask *pass, int dimx, int dimy, int nchan, int threshold,
+							 unsigned char const *resultIJ, int resultIJStride, unsigned char const *resultII, int resultIIStride,
+							 unsigned char *diff, int diffStride, unsigned char *mask, int maskStride)
+{
+	const int nblockx = (dimx + GBF_MASK_BLOCK - 1) / GBF_MASK_BLOCK, nblocky = (dimy + GBF_MASK_BLOCK - 1) / GBF_MASK_BLOCK;
+
+	if (nchan < 1 || nchan > GBF_MAX_NCHAN)
+		return (0);
+	if (nblockx * nblocky > pass->capacity)
+	{
+		delete[] pass->pending;
+		pass->capacity = 0;
+		if ((pass->pending = new (std::nothrow) std::atomic<int>[nblockx * nblocky]) == NULL)
+			return (0);
+		pass->capacity = nblockx * nblocky;
+	}
+
+	pass->dimx = dimx;
+	pass->dimy = dimy;
+	pass->nchan = nchan;
+	pass->threshold = threshold;
+	pass->resultIJ = resultIJ;
+	pass->resultIJStride = resultIJStride;
+	pass->resultII = resultII;
+	pass->resultIIStride = resultIIStride;
+	pass->diff = diff;
+	pass->diffStride = diffStride;
+	pass->mask = mask;
+	pass->maskStride = maskStride;
+	pass->nblockx = nblockx;
+	pass->nblocky = nblocky;
+	for (int b = 0; b < nblockx * nblocky; b++)
+		pass->pending[b].store(GuidedBilateralBlockArea(pass, b, 0, dimx, 0, dimy), std::memory_order_relaxed);
+
+	return (1);
+}
+
+// One erosion (dilate false) or dilation by the 3 x 3 cross of the pixels [x0, x1) x [y0, y1). src and dst hold the
+// image from the pixels (sx, sy) and (dx, dy) on, src covers the neighbors inside the image, the others are ignored.
+static void GuidedBilateralCross(bool dilate, int dimx, int dimy, int nchan, unsigned char const *src, int srcStride, int sx, int sy,
+								 unsigned char *dst, int dstStride, int dx, int dy, int x0, int x1, int y0, int y1)
+{
+	for (int y = y0; y < y1; y++)
+	{
+		unsigned char const *row = src + (y - sy) * srcStride + (x0 - sx) * nchan;
+		unsigned char *out = dst + (y - dy) * dstStride + (x0 - dx) * nchan;
+		const bool up = y > 0, down = y + 1 < dimy;
+		for (int x = x0; x < x1; x++, row += nchan, out += nchan)
+		{
+			const bool left = x > 0, right = x + 1 < dimx;
+			for (int c = 0; c < nchan; c++)
+			{
+				int v = row[c];
+				if (dilate)
+				{
+					v = left && row[c - nchan] > v ? row[c - nchan] : v;
+					v = right && row[c + nchan] > v ? row[c + nchan] : v;
+					v = up && row[c - srcStride] > v ? row[c - srcStride] : v;
+					v = down && row[c + srcStride] > v ? row[c + srcStride] : v;
+				}
+				else
+				{
+					v = left && row[c - nchan] < v ? row[c - nchan] : v;
+					v = right && row[c + nchan] < v ? row[c + nchan] : v;
+					v = up && row[c - srcStride] < v ? row[c - srcStride] : v;
+					v = down && row[c + srcStride] < v ? row[c + srcStride] : v;
+				}
+				out[c] = (unsigned char)v;
+			}
+		}
+	}
+}
+
+// the opening of the block b, its diff and the halo are done
+static void GuidedBilateralOpenBlock(const GuidedBilateralMask *pass, int b)
+{
+	const int dimx = pass->dimx, dimy = pass->dimy, nchan = pass->nchan, span = GBF_MASK_SPAN * nchan;
+	const int bx = (b % pass->nblockx) * GBF_MASK_BLOCK, by = (b / pass->nblockx) * GBF_MASK_BLOCK;
+	unsigned char first[GBF_MASK_SPAN * GBF_MASK_SPAN * GBF_MAX_NCHAN], second[GBF_MASK_SPAN * GBF_MASK_SPAN * GBF_MAX_NCHAN];
+
+	// the pixels of the block and r around it inside the image
+	int x0[4], x1[4], y0[4], y1[4];
+	for (int r = 0; r < 4; r++)
+	{
+		x0[r] = GuidedBilateralClamp(bx - r, 0, dimx);
+		x1[r] = GuidedBilateralClamp(bx + GBF_MASK_BLOCK + r, 0, dimx);
+		y0[r] = GuidedBilateralClamp(by - r, 0, dimy);
+		y1[r] = GuidedBilateralClamp(by + GBF_MASK_BLOCK + r, 0, dimy);
+	}
+
+	// each step shrinks the area by a pixel: erosions over the block and 3 then 2 pixels, dilations over 1 then 0
+	GuidedBilateralCross(false, dimx, dimy, nchan, pass->diff, pass->diffStride, 0, 0, first, span, x0[3], y0[3], x0[3], x1[3], y0[3], y1[3]);
+	GuidedBilateralCross(false, dimx, dimy, nchan, first, span, x0[3], y0[3], second, span, x0[2], y0[2], x0[2], x1[2], y0[2], y1[2]);
+	GuidedBilateralCross(true, dimx, dimy, nchan, second, span, x0[2], y0[2], first, span, x0[1], y0[1], x0[1], x1[1], y0[1], y1[1]);
+	GuidedBilateralCross(true, dimx, dimy, nchan, first, span, x0[1], y0[1], pass->mask, pass->maskStride, 0, 0, x0[0], x1[0], y0[0], y1[0]);
+}
+
+// counts the diff pixels of the tile in the blocks whose halo it crosses and opens the ones complete
+static void GuidedBilateralMaskDone(GuidedBilateralMask *pass, int jbegin, int jend, int ibegin, int iend)
+{
+	const int bx0 = GuidedBilateralClamp((ibegin - GBF_MASK_HALO) / GBF_MASK_BLOCK, 0, pass->nblockx - 1);
+	const int bx1 = GuidedBilateralClamp((iend + GBF_MASK_HALO - 1) / GBF_MASK_BLOCK, 0, pass->nblockx - 1);
+	const int by0 = GuidedBilateralClamp((jbegin - GBF_MASK_HALO) / GBF_MASK_BLOCK, 0, pass->nblocky - 1);
+	const int by1 = GuidedBilateralClamp((jend + GBF_MASK_HALO - 1) / GBF_MASK_BLOCK, 0, pass->nblocky - 1);
+
+	for (int by = by0; by <= by1; by++)
+		for (int bx = bx0; bx <= bx1; bx++)
+		{
+			const int b = by * pass->nblockx + bx;
+			const int area = GuidedBilateralBlockArea(pass, b, ibegin, iend, jbegin, jend);
+			// the diff writes of every tile are seen by the thread that takes the count to 0
+			if (area > 0 && pass->pending[b].fetch_sub(area, std::memory_order_acq_rel) == area)
+				GuidedBilateralOpenBlock(pass, b);
+		}
+}
+
+void GuidedBilateralMaskTile(void *user, int jbegin, int jend, int ibegin, int iend)
+{
+	GuidedBilateralMask *pass = (GuidedBilateralMask *)user;
+	const int nchan = pass->nchan, threshold = pass->threshold;
+
+	for (int j = jbegin; j < jend; j++)
+	{
+		unsigned char const *ij = pass->resultIJ + j * pass->resultIJStride + ibegin * nchan;
+		unsigned char const *ii = pass->resultII + j * pass->resultIIStride + ibegin * nchan;
+		unsigned char *diff = pass->diff + j * pass->diffStride + ibegin * nchan;
+		for (int i = 0; i < (iend - ibegin) * nchan; i++)
+		{
+			const int d = ii[i] > ij[i] ? ii[i] - ij[i] : ij[i] - ii[i];
+			diff[i] = d > threshold ? 0 : 255;
+		}
+	}
+
+	GuidedBilateralMaskDone(pass, jbegin, jend, ibegin, iend);
+}
+
+void GuidedBilateralMaskSkipped(GuidedBilateralMask *pass, int jbegin, int jend, int ibegin, int iend)
+{
+	for (int j = jbegin; j < jend; j++)
+		memset(pass->diff + j * pass->diffStride + ibegin * pass->nchan, 255, (iend - ibegin) * pass->nchan);
+
+	GuidedBilateralMaskDone(pass, jbegin, jend, ibegin, iend);
+}
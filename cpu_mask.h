@@ -0,0 +1,44 @@
+#ifndef CPU_MASK_H
+#define CPU_MASK_H
+
+#include <atomic>
+
+// Comparison mask of the two filters, fused and tile by tile: the inverted threshold of |II - IJ| into diff, then the
+// opening of diff by the 3 x 3 cross, two erosions and two dilations, into mask. It gives the bytes of cv::absdiff,
+// cv::threshold(THRESH_BINARY_INV) and cv::morphologyEx(MORPH_OPEN) with the 3 x 3 ellipse, the cross, 2 iterations
+// and the default border, which leaves the pixels outside the image out of the min and the max.
+//
+// GuidedBilateralMaskTile is the done callback of the filter. The opening of a block of GBF_MASK_BLOCK pixels needs
+// diff GBF_MASK_HALO pixels around it: every block counts the pixels of diff done in that area and the thread that
+// completes the count opens the block, while the filter runs on the rest of the frame.
+#define GBF_MASK_BLOCK 32
+#define GBF_MASK_HALO 4
+
+struct GuidedBilateralMask
+{
+	int dimx, dimy, nchan, threshold;
+	unsigned char const *resultIJ, *resultII;
+	int resultIJStride, resultIIStride;
+	unsigned char *diff, *mask;
+	int diffStride, maskStride;
+	// blocks and their diff pixels done, grown by GuidedBilateralMaskBegin
+	int nblockx, nblocky;
+	std::atomic<int> *pending;
+	int capacity;
+};
+
+void GuidedBilateralMaskInit(GuidedBilateralMask *pass);
+void GuidedBilateralMaskFree(GuidedBilateralMask *pass);
+
+// sets up the pass of a frame, returns 0 if the block counters cannot be allocated
+int GuidedBilateralMaskBegin(GuidedBilateralMask *pass, int dimx, int dimy, int nchan, int threshold,
+							 unsigned char const *resultIJ, int resultIJStride, unsigned char const *resultII, int resultIIStride,
+							 unsigned char *diff, int diffStride, unsigned char *mask, int maskStride);
+
+// the results of the pixels [ibegin, iend) of the rows [jbegin, jend) are final, pass is a GuidedBilateralMask
+void GuidedBilateralMaskTile(void *pass, int jbegin, int jend, int ibegin, int iend);
+
+// the comparison of the tile is known to stay under the threshold, its diff is 255 without the results
+void GuidedBilateralMaskSkipped(GuidedBilateralMask *pass, int jbegin, int jend, int ibegin, int iend);
+
+#endif
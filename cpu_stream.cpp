@@ -0,0 +1,194 @@
+#include "cpu_stream.h"
+
+#include <ctype.h>
+
+#include <vector>
+
+// 64 bit file offsets on every platform
+static int GuidedBilateralSeek(FILE *file, long long offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, offset, SEEK_SET);
+#else
+	return fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+}
+
+// next decimal field of a pnm header, skipping the blanks and the # comments
+static int GuidedBilateralPnmField(FILE *file)
+{
+	int ch = fgetc(file), value = 0, digits = 0;
+
+	while (ch == '#' || isspace(ch))
+	{
+		if (ch == '#')
+			while (ch != '\n' && ch != EOF)
+				ch = fgetc(file);
+		ch = fgetc(file);
+	}
+	for (; ch >= '0' && ch <= '9' && digits < 9; ch = fgetc(file), digits++)
+		value = value * 10 + (ch - '0');
+
+	// a single blank ends the field, the maxval one is the last byte of the header
+	return digits > 0 && isspace(ch) ? value : -1;
+}
+
+int GuidedBilateralStreamOpen(const char *path, GuidedBilateralStreamImage *image)
+{
+	char magic[2];
+
+	if ((image->file = fopen(path, "rb")) == NULL)
+		return (0);
+	if (fread(magic, 1, 2, image->file) != 2 || magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6'))
+	{
+		GuidedBilateralStreamClose(image);
+		return (0);
+	}
+
+	image->nchan = magic[1] == '5' ? 1 : 3;
+	image->planar = false;
+	image->dimx = GuidedBilateralPnmField(image->file);
+	image->dimy = GuidedBilateralPnmField(image->file);
+	const int maxval = GuidedBilateralPnmField(image->file);
+	if (image->dimx <= 0 || image->dimy <= 0 || maxval <= 0 || maxval > 255)
+	{
+		GuidedBilateralStreamClose(image);
+		return (0);
+	}
+
+#ifdef _WIN32
+	image->offset = _ftelli64(image->file);
+#else
+	image->offset = (long long)ftello(image->file);
+#endif
+	return (1);
+}
+
+int GuidedBilateralStreamOpenRaw(const char *path, int dimx, int dimy, int nchan, bool planar, long long offset, GuidedBilateralStreamImage *image)
+{
+	image->file = NULL;
+	if (dimx <= 0 || dimy <= 0 || nchan < 1 || nchan > GBF_MAX_NCHAN)
+		return (0);
+	if ((image->file = fopen(path, "rb")) == NULL)
+		return (0);
+
+	image->offset = offset;
+	image->dimx = dimx;
+	image->dimy = dimy;
+	image->nchan = nchan;
+	image->planar = planar;
+
+	return (1);
+}
+
+int GuidedBilateralStreamCreate(const char *path, int dimx, int dimy, int nchan, GuidedBilateralStreamImage *image)
+{
+	if ((image->file = fopen(path, "wb")) == NULL)
+		return (0);
+
+	image->offset = 0;
+	if (nchan == 1 || nchan == 3)
+		image->offset = fprintf(image->file, "P%c\n%d %d\n255\n", nchan == 1 ? '5' : '6', dimx, dimy);
+	image->dimx = dimx;
+	image->dimy = dimy;
+	image->nchan = nchan;
+	image->planar = false;
+
+	return image->offset >= 0;
+}
+
+void GuidedBilateralStreamClose(GuidedBilateralStreamImage *image)
+{
+	if (image->file)
+		fclose(image->file);
+	image->file = NULL;
+}
+
+int GuidedBilateralStreamRead(const GuidedBilateralStreamImage *image, int jbegin, int jend, unsigned char *rows)
+{
+	const int dimx = image->dimx, nchan = image->nchan;
+	const size_t row = (size_t)dimx * nchan;
+
+	if (jbegin < 0 || jend > image->dimy || jbegin > jend)
+		return (0);
+
+	if (!image->planar)
+	{
+		if (GuidedBilateralSeek(image->file, image->offset + (long long)jbegin * row) != 0)
+			return (0);
+		return fread(rows, row, jend - jbegin, image->file) == (size_t)(jend - jbegin);
+	}
+
+	// a row of each plane, then spread over the interleaved row
+	std::vector<unsigned char> plane(dimx);
+	for (int c = 0; c < nchan; c++)
+	{
+		if (GuidedBilateralSeek(image->file, image->offset + ((long long)c * image->dimy + jbegin) * dimx) != 0)
+			return (0);
+		for (int j = jbegin; j < jend; j++)
+		{
+			if (fread(plane.data(), 1, dimx, image->file) != (size_t)dimx)
+				return (0);
+			unsigned char *pixels = rows + (j - jbegin) * row + c;
+			for (int i = 0; i < dimx; i++)
+				pixels[i * nchan] = plane[i];
+		}
+	}
+
+	return (1);
+}
+
+int GuidedBilateralStreamWrite(GuidedBilateralStreamImage *image, int jbegin, int jend, unsigned char const *rows)
+{
+	const size_t row = (size_t)image->dimx * image->nchan;
+	return fwrite(rows, row, jend - jbegin, image->file) == (size_t)(jend - jbegin);
+}
+
+size_t GuidedBilateralStreamBytes(int dimx, int nchan, int demisize, int stripRows)
+{
+	const size_t row = (size_t)dimx * nchan, window = (size_t)stripRows + 2 * demisize;
+	// the two input windows, their float planes for both filters and the two result strips
+	return 2 * window * row + 2 * window * row * sizeof(float) + 2 * (size_t)stripRows * row;
+}
+
+int GuidedBilateralStreamFilter(const GuidedBilateralStreamImage *orig, const GuidedBilateralStreamImage *guide, GuidedBilateralTables const *tables,
+								int stripRows, GuidedBilateralStreamImage *resultIJ, GuidedBilateralStreamImage *resultII)
+{
+	const int dimx = orig->dimx, dimy = orig->dimy, nchan = orig->nchan, demisize = tables->demisize;
+	const int row = dimx * nchan;
+
+	if (guide->dimx != dimx || guide->dimy != dimy || guide->nchan != nchan || nchan > GBF_MAX_NCHAN || stripRows <= 0)
+		return (0);
+	if (resultIJ->dimx != dimx || resultIJ->dimy != dimy || resultIJ->nchan != nchan)
+		return (0);
+	if (resultII && (resultII->dimx != dimx || resultII->dimy != dimy || resultII->nchan != nchan))
+		return (0);
+	if (stripRows > dimy)
+		stripRows = dimy;
+
+	// window of the strip and its halo
+	const size_t window = (size_t)stripRows + 2 * demisize;
+	std::vector<unsigned char> origRows(window * row), guideRows(window * row), ij((size_t)stripRows * row), ii((size_t)stripRows * row);
+	std::vector<float> scratch(2 * window * row);
+
+	for (int j0 = 0; j0 < dimy; j0 += stripRows)
+	{
+		const int j1 = j0 + stripRows < dimy ? j0 + stripRows : dimy;
+		const int top = j0 < demisize ? j0 : demisize;
+		const int bottom = dimy - j1 < demisize ? dimy - j1 : demisize;
+
+		// the halo rows are read again with the next strip, 2 * demisize rows against stripRows
+		if (!GuidedBilateralStreamRead(orig, j0 - top, j1 + bottom, origRows.data()) ||
+			!GuidedBilateralStreamRead(guide, j0 - top, j1 + bottom, guideRows.data()))
+			return (0);
+		if (!GuidedBilateralFilterDualStrip(dimx, top + (j1 - j0) + bottom, nchan, origRows.data(), row, guideRows.data(), row,
+											top, j1 - j0, tables, scratch.data(), ij.data(), row, ii.data(), row))
+			return (0);
+		if (!GuidedBilateralStreamWrite(resultIJ, j0, j1, ij.data()))
+			return (0);
+		if (resultII && !GuidedBilateralStreamWrite(resultII, j0, j1, ii.data()))
+			return (0);
+	}
+
+	return (1);
+}
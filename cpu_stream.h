@@ -0,0 +1,45 @@
+#ifndef CPU_STREAM_H
+#define CPU_STREAM_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "cpu_filter.h"
+
+// Out of core filtering of images too large for the float planes of a whole frame, 2 * nchan floats per pixel.
+// The pair is read in strips of rows with the demisize rows of halo above and below them, each strip runs the whole
+// schedule with GuidedBilateralFilterDualStrip and its results are appended to the output files: the memory is
+// proportional to the strip height and the width, never to the image height, and the results are the ones of the
+// whole image filter. The inputs are binary pgm / ppm with a maxval up to 255, or raw 8 bit files, interleaved or
+// planar; the files are read with 64 bit offsets.
+struct GuidedBilateralStreamImage
+{
+	FILE *file;
+	// byte offset of the first pixel in the file
+	long long offset;
+	int dimx, dimy, nchan;
+	// raw files only: one plane of dimx * dimy bytes per channel instead of interleaved pixels
+	bool planar;
+};
+
+// opens a binary pgm (P5) or ppm (P6), returns 0 if the file is not one or has 16 bit samples
+int GuidedBilateralStreamOpen(const char *path, GuidedBilateralStreamImage *image);
+// opens a headerless file of dimx * dimy pixels of nchan 8 bit channels starting at offset
+int GuidedBilateralStreamOpenRaw(const char *path, int dimx, int dimy, int nchan, bool planar, long long offset, GuidedBilateralStreamImage *image);
+// creates a pgm for 1 channel, a ppm for 3, a raw interleaved file otherwise, the rows are appended in order
+int GuidedBilateralStreamCreate(const char *path, int dimx, int dimy, int nchan, GuidedBilateralStreamImage *image);
+void GuidedBilateralStreamClose(GuidedBilateralStreamImage *image);
+
+// reads the rows [jbegin, jend) as interleaved pixels, row after row
+int GuidedBilateralStreamRead(const GuidedBilateralStreamImage *image, int jbegin, int jend, unsigned char *rows);
+// appends jend - jbegin interleaved rows
+int GuidedBilateralStreamWrite(GuidedBilateralStreamImage *image, int jbegin, int jend, unsigned char const *rows);
+
+// bytes held by GuidedBilateralStreamFilter for strips of stripRows rows
+size_t GuidedBilateralStreamBytes(int dimx, int nchan, int demisize, int stripRows);
+
+// filters orig guided by guide into resultIJ and by itself into resultII, strip by strip. resultII may be NULL.
+int GuidedBilateralStreamFilter(const GuidedBilateralStreamImage *orig, const GuidedBilateralStreamImage *guide, GuidedBilateralTables const *tables,
+								int stripRows, GuidedBilateralStreamImage *resultIJ, GuidedBilateralStreamImage *resultII);
+
+#endif
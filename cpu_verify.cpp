@@ -0,0 +1,704 @@
+#include "cpu_verify.h"
+#include "cpu_filter.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <vector>
+
+// the float variants multiply the spatial weights before the others, the legacy code after: their floats differ in
+// the last bits, which can move a truncated result by a level
+static const GuidedBilateralVerifyTolerance tolerances[] = {
+	{"step", 0.001f, 100.0},
+	{"filter", 1.0f, 60.0},
+	{"interleaved", 1.0f, 60.0},
+	{"dual_rows", 1.0f, 60.0},
+	{"dual_tiles", 1.0f, 60.0},
+	{"dual_column_tiles", 1.0f, 60.0},
+	{"batch", 1.0f, 60.0},
+	{"strided", 1.0f, 60.0},
+	// the strips of the out of core filter, windows with their halo, against dual_rows
+	{"strip", 0.0f, 0.0},
+	{"static_f32", 1.0f, 60.0},
+	{"static_f16", 2.0f, 55.0},
+	{"static_u8", 32.0f, 45.0},
+	{"fixed", 32.0f, 40.0},
+	// an approximation of the schedule, reported for its accuracy cost and checked against the scalar kernel only
+	{"pyramid", 255.0f, 0.0},
+	// the comparison over the threshold on a tile the pre-screen skips, by how much
+	{"screen", 0.0f, 0.0},
+	// the other legacy filters as policies of the planar filter, on the first plane. the bilateral sums start at 0
+	// in the legacy code, at 1e-6 in the policy. the unit intensity weights of the joint / cross step leave the
+	// legacy products, the same bits
+	{"robust", 1.0f, 60.0},
+	{"bilateral", 1.0f, 60.0},
+	{"jointcross", 0.0f, 0.0},
+};
+#define GBF_VERIFY_VARIANTS (int)(sizeof(tolerances) / sizeof(tolerances[0]))
+
+// legacy GuidedBilateralFilterStep, the mex code without the matlab gateway: planar, ncol 1 or 3 guide planes
+static int GuidedBilateralLegacyStep(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+									 float sscale, float iscale, float ipower, float gscale, float gpower, float *filtered)
+{
+	int i, j, k, l, value, ediff, currentGuide[3], diffGuide;
+	float wguide, somme, poids, pixelMoy, currentIntensity, diff, rdiff, *sweight = NULL, iweight[257], gweight[256];
+
+	/* spatial weight */
+	if ((sweight = (float *)malloc((demisize + 1) * sizeof(float))) == NULL)
+		return (0);
+	for (i = 0; i <= demisize; i++)
+	{
+		if (sscale > 0.0f)
+			sweight[i] = exp(-0.5f * (float)(i * i) / (sscale * sscale));
+		else
+			sweight[i] = 1.0f;
+	}
+
+	/* intensity weight */
+	for (i = 0; i <= 256; i++)
+	{
+		if (ipower != 1.0f)
+			iweight[i] = pow(1.0f + (float)(i * i) / (iscale * iscale), ipower - 1.0f);
+		else
+			iweight[i] = 1.0f;
+	}
+
+	/* guide weight */
+	for (i = 0; i <= 255; i++)
+	{
+		if (gpower != 0.0f)
+			gweight[i] = exp(-(pow(1.0f + (float)(i * i) / (gscale * gscale), gpower) - 1.0f) / gpower);
+		else
+			gweight[i] = 1.0f / (1.0f + (float)(i * i) / (gscale * gscale));
+	}
+	for (j = 0; j < dimy; j++)
+	{
+		for (i = 0; i < dimx; i++)
+		{
+			somme = 1e-6f;
+			pixelMoy = 0.0f;
+			currentIntensity = filtered[j * dimx + i];
+			currentGuide[0] = guide[j * dimx + i];
+			if (ncol == 3)
+			{
+				currentGuide[1] = guide[dimx * dimy + j * dimx + i];
+				currentGuide[2] = guide[2 * dimx * dimy + j * dimx + i];
+			}
+			for (k = -demisize; k <= demisize; k++)
+			{
+				if ((j + k >= 0) && (j + k < dimy))
+				{
+					for (l = -demisize; l <= demisize; l++)
+					{
+						if ((i + l >= 0) && (i + l < dimx))
+						{
+							value = orig[(j + k) * dimx + i + l];
+							diff = fabs((float)value - currentIntensity);
+							ediff = (int)floor(diff);
+							rdiff = diff - (float)ediff;
+							diffGuide = abs(guide[(j + k) * dimx + i + l] - currentGuide[0]);
+							wguide = gweight[diffGuide];
+							if (ncol == 3)
+							{
+								diffGuide = abs(guide[dimx * dimy + (j + k) * dimx + i + l] - currentGuide[1]);
+								wguide *= gweight[diffGuide];
+								diffGuide = abs(guide[2 * dimx * dimy + (j + k) * dimx + i + l] - currentGuide[2]);
+								wguide *= gweight[diffGuide];
+							}
+							poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * sweight[abs(k)] * sweight[abs(l)] * wguide;
+							somme += poids;
+							pixelMoy += poids * (float)value;
+						}
+					}
+				}
+			}
+			filtered[j * dimx + i] = pixelMoy / somme;
+		}
+	}
+	free(sweight);
+
+	return (1);
+}
+
+// legacy GuidedBilateralFilter
+static int GuidedBilateralLegacyFilter(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+									   float sscale, float iscale, float ipower, float gscale, float gpower, unsigned char *result)
+{
+	int i, num = 8;
+	std::vector<float> filtered(dimx * dimy);
+
+	/* init image */
+	for (i = 0; i < dimx * dimy; i++)
+		filtered[i] = (float)(orig[i]);
+
+	/* GNC */
+	if (ipower <= 1.0f)
+	{
+		if (!GuidedBilateralLegacyStep(dimx, dimy, ncol, orig, guide, demisize, 0.0, iscale, 1.0, gscale * 5.0, gpower, filtered.data()))
+			return (0);
+		num--;
+	}
+
+	if (ipower <= 0.5f)
+	{
+		if (!GuidedBilateralLegacyStep(dimx, dimy, ncol, orig, guide, demisize, sscale, iscale, 0.5, gscale, gpower, filtered.data()))
+			return (0);
+		num--;
+	}
+
+	if (ipower <= 0.0f)
+	{
+		if (!GuidedBilateralLegacyStep(dimx, dimy, ncol, orig, guide, demisize, sscale, iscale, 0.0, gscale, gpower, filtered.data()))
+			return (0);
+		num--;
+	}
+
+	/* final */
+	for (i = 0; i < num; i++)
+	{
+		if (!GuidedBilateralLegacyStep(dimx, dimy, ncol, orig, guide, demisize, sscale, iscale, ipower, gscale, gpower, filtered.data()))
+			return (0);
+	}
+
+	for (i = 0; i < dimx * dimy; i++)
+		result[i] = (unsigned char)(filtered[i]);
+
+	return (1);
+}
+
+// legacy BilateralFilter, bilateralfilter_mex.c: one plane, gaussian intensity weights, one pass
+static int GuidedBilateralLegacyBilateral(int dimx, int dimy, unsigned char const *orig, int demisize, float sscale, float iscale, unsigned char *result)
+{
+	int i, j, k, l, value, diff, currentIntensity;
+	float somme, poids, pixelMoy, *sweight = NULL, iweight[256];
+
+	/* spatial weight */
+	if ((sweight = (float *)malloc((demisize + 1) * sizeof(float))) == NULL)
+		return (0);
+	for (i = 0; i <= demisize; i++)
+	{
+		if (sscale > 0.0f)
+			sweight[i] = exp(-0.5f * ((float)i * (float)i) / (sscale * sscale));
+		else
+			sweight[i] = 1.0f;
+	}
+
+	/* intensity weight */
+	for (i = 0; i <= 255; i++)
+		iweight[i] = exp(-0.5f * (float)(i * i) / (iscale * iscale));
+
+	for (j = 0; j < dimy; j++)
+	{
+		for (i = 0; i < dimx; i++)
+		{
+			somme = 0.0f;
+			pixelMoy = 0.0f;
+			currentIntensity = orig[j * dimx + i];
+			for (k = -demisize; k <= demisize; k++)
+			{
+				if ((j + k >= 0) && (j + k < dimy))
+				{
+					for (l = -demisize; l <= demisize; l++)
+					{
+						if ((i + l >= 0) && (i + l < dimx))
+						{
+							value = orig[(j + k) * dimx + i + l];
+							diff = abs(value - currentIntensity);
+							poids = iweight[diff] * sweight[abs(k)] * sweight[abs(l)];
+							somme += poids;
+							pixelMoy += poids * (float)value;
+						}
+					}
+				}
+			}
+			poids = pixelMoy / somme;
+			result[j * dimx + i] = (unsigned char)(poids);
+		}
+	}
+	free(sweight);
+
+	return (1);
+}
+
+// legacy RobustBilateralFilterStep, robustbilateralfilter_mex.c: the guided step without the guide
+static int GuidedBilateralLegacyRobustStep(int dimx, int dimy, unsigned char const *orig, int demisize, float sscale, float iscale, float ipower, float *filtered)
+{
+	int i, j, k, l, value, ediff;
+	float somme, poids, pixelMoy, currentIntensity, diff, rdiff, *sweight = NULL, iweight[257];
+
+	/* spatial weight */
+	if ((sweight = (float *)malloc((demisize + 1) * sizeof(float))) == NULL)
+		return (0);
+	for (i = 0; i <= demisize; i++)
+	{
+		if (sscale > 0.0f)
+			sweight[i] = exp(-0.5f * (float)(i * i) / (sscale * sscale));
+		else
+			sweight[i] = 1.0f;
+	}
+
+	/* intensity weight */
+	for (i = 0; i <= 256; i++)
+	{
+		if (ipower != 1.0f)
+			iweight[i] = pow(1.0f + (float)(i * i) / (iscale * iscale), ipower - 1.0f);
+		else
+			iweight[i] = 1.0f;
+	}
+
+	for (j = 0; j < dimy; j++)
+	{
+		for (i = 0; i < dimx; i++)
+		{
+			somme = 1e-6f;
+			pixelMoy = 0.0f;
+			currentIntensity = filtered[j * dimx + i];
+			for (k = -demisize; k <= demisize; k++)
+			{
+				if ((j + k >= 0) && (j + k < dimy))
+				{
+					for (l = -demisize; l <= demisize; l++)
+					{
+						if ((i + l >= 0) && (i + l < dimx))
+						{
+							value = orig[(j + k) * dimx + i + l];
+							diff = fabs((float)value - currentIntensity);
+							ediff = (int)floor(diff);
+							rdiff = diff - (float)ediff;
+							poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * sweight[abs(k)] * sweight[abs(l)];
+							somme += poids;
+							pixelMoy += poids * (float)value;
+						}
+					}
+				}
+			}
+			filtered[j * dimx + i] = pixelMoy / somme;
+		}
+	}
+	free(sweight);
+
+	return (1);
+}
+
+// legacy RobustBilateralFilter
+static int GuidedBilateralLegacyRobust(int dimx, int dimy, unsigned char const *orig, int demisize, float sscale, float iscale, float ipower, unsigned char *result)
+{
+	int i, num = 8;
+	std::vector<float> filtered(dimx * dimy);
+
+	/* init image */
+	for (i = 0; i < dimx * dimy; i++)
+		filtered[i] = (float)(orig[i]);
+
+	/* GNC */
+	if (ipower <= 1.0f)
+	{
+		if (!GuidedBilateralLegacyRobustStep(dimx, dimy, orig, demisize, 0.0, iscale, 1.0f, filtered.data()))
+			return (0);
+		num--;
+	}
+
+	if (ipower <= 0.5f)
+	{
+		if (!GuidedBilateralLegacyRobustStep(dimx, dimy, orig, demisize, sscale, iscale, 0.5f, filtered.data()))
+			return (0);
+		num--;
+	}
+
+	if (ipower <= 0.0f)
+	{
+		if (!GuidedBilateralLegacyRobustStep(dimx, dimy, orig, demisize, sscale, iscale, 0.0f, filtered.data()))
+			return (0);
+		num--;
+	}
+
+	/* final */
+	for (i = 0; i < num; i++)
+	{
+		if (!GuidedBilateralLegacyRobustStep(dimx, dimy, orig, demisize, sscale, iscale, ipower, filtered.data()))
+			return (0);
+	}
+
+	for (i = 0; i < dimx * dimy; i++)
+		result[i] = (unsigned char)(filtered[i]);
+
+	return (1);
+}
+
+// legacy JointCrossBilateralFilter, jointcrossbilateralfilter_mex.c: one plane guided by ncol planes, one pass
+static int GuidedBilateralLegacyJointCross(int dimx, int dimy, int ncol, unsigned char const *orig, unsigned char const *guide, int demisize,
+										   float sscale, float gscale, unsigned char *result)
+{
+	int i, j, k, l, value, currentGuide[3], diffGuide;
+	float somme, poids, pixelMoy, wguide, *sweight = NULL, gweight[256];
+
+	/* spatial weight */
+	if ((sweight = (float *)malloc((demisize + 1) * sizeof(float))) == NULL)
+		return (0);
+	for (i = 0; i <= demisize; i++)
+	{
+		if (sscale > 0.0f)
+			sweight[i] = exp(-0.5f * ((float)i * (float)i) / (sscale * sscale));
+		else
+			sweight[i] = 1.0f;
+	}
+
+	/* guide weight */
+	for (i = 0; i <= 255; i++)
+		gweight[i] = exp(-0.5f * (float)(i * i) / (gscale * gscale));
+
+	for (j = 0; j < dimy; j++)
+	{
+		for (i = 0; i < dimx; i++)
+		{
+			somme = 1e-6f;
+			pixelMoy = 0.0f;
+			currentGuide[0] = guide[j * dimx + i];
+			if (ncol == 3)
+			{
+				currentGuide[1] = guide[dimx * dimy + j * dimx + i];
+				currentGuide[2] = guide[2 * dimx * dimy + j * dimx + i];
+			}
+			for (k = -demisize; k <= demisize; k++)
+			{
+				if ((j + k >= 0) && (j + k < dimy))
+				{
+					for (l = -demisize; l <= demisize; l++)
+					{
+						if ((i + l >= 0) && (i + l < dimx))
+						{
+							value = orig[(j + k) * dimx + i + l];
+							diffGuide = abs(guide[(j + k) * dimx + i + l] - currentGuide[0]);
+							wguide = gweight[diffGuide];
+							if (ncol == 3)
+							{
+								diffGuide = abs(guide[dimx * dimy + (j + k) * dimx + i + l] - currentGuide[1]);
+								wguide *= gweight[diffGuide];
+								diffGuide = abs(guide[2 * dimx * dimy + (j + k) * dimx + i + l] - currentGuide[2]);
+								wguide *= gweight[diffGuide];
+							}
+							poids = sweight[abs(k)] * sweight[abs(l)] * wguide;
+							somme += poids;
+							pixelMoy += poids * (float)value;
+						}
+					}
+				}
+			}
+			poids = pixelMoy / somme;
+			result[j * dimx + i] = (unsigned char)(poids);
+		}
+	}
+	free(sweight);
+
+	return (1);
+}
+
+// channel c of an interleaved image as a plane
+static void GuidedBilateralVerifyPlane(int plane, int nchan, int c, unsigned char const *image, unsigned char *out)
+{
+	for (int i = 0; i < plane; i++)
+		out[i] = image[i * nchan + c];
+}
+
+// maximum absolute difference and psnr of n values in [0, 255]
+template <class T>
+static void GuidedBilateralVerifyCompare(size_t n, T const *a, T const *b, float &maxDiff, double &psnr)
+{
+	double squares = 0.0;
+
+	maxDiff = 0.0f;
+	for (size_t i = 0; i < n; i++)
+	{
+		const double diff = fabs((double)a[i] - (double)b[i]);
+		if (diff > maxDiff)
+			maxDiff = (float)diff;
+		squares += diff * diff;
+	}
+	psnr = squares > 0.0 ? 10.0 * log10(255.0 * 255.0 * (double)n / squares) : INFINITY;
+}
+
+static int GuidedBilateralVerifyVariant(const char *variant)
+{
+	for (int v = 0; v < GBF_VERIFY_VARIANTS; v++)
+		if (strcmp(tolerances[v].variant, variant) == 0)
+			return v;
+	return -1;
+}
+
+// writes the line of a variant, returns 1 if it is outside its tolerance or differs from the scalar kernel
+static int GuidedBilateralVerifyReport(FILE *out, const char *name, const char *kernel, int variant, float maxDiff, double psnr, bool scalar)
+{
+	const GuidedBilateralVerifyTolerance &tolerance = tolerances[variant];
+	const int failed = maxDiff > tolerance.maxDiff || psnr < tolerance.minPsnr || !scalar;
+	fprintf(out, "%-28s %-8s %-18s max %9.6f psnr %7.2f %s%s\n", name, kernel, tolerance.variant, maxDiff, psnr,
+			failed ? "FAIL" : "ok", scalar ? "" : ", differs from the scalar kernel");
+	return failed;
+}
+
+int GuidedBilateralVerifyPair(FILE *out, const char *name, int dimx, int dimy, int nchan, unsigned char const *orig,
+							  unsigned char const *guide, const GuidedBilateralVerifyParams &params)
+{
+	const int plane = dimx * dimy, size = plane * nchan, demisize = params.demisize;
+	const float sscale = params.sscale, iscale = params.iscale, ipower = params.ipower, gscale = params.gscale, gpower = params.gpower;
+	int failures = 0;
+
+	// legacy references: IJ and II channel by channel, the planar filter and one step with a guide of ncol planes
+	const int ncol = nchan >= 3 ? 3 : 1;
+	std::vector<unsigned char> origPlanes(size), guidePlanes(size), refIJ(size), refII(size), refPlanar(plane), plane8(plane);
+	std::vector<float> refStep(plane), step(plane);
+	for (int c = 0; c < nchan; c++)
+	{
+		GuidedBilateralVerifyPlane(plane, nchan, c, orig, origPlanes.data() + c * plane);
+		GuidedBilateralVerifyPlane(plane, nchan, c, guide, guidePlanes.data() + c * plane);
+	}
+	for (int c = 0; c < nchan; c++)
+	{
+		unsigned char const *origPlane = origPlanes.data() + c * plane;
+		GuidedBilateralLegacyFilter(dimx, dimy, 1, origPlane, guidePlanes.data() + c * plane, demisize, sscale, iscale, ipower, gscale, gpower, plane8.data());
+		for (int i = 0; i < plane; i++)
+			refIJ[i * nchan + c] = plane8[i];
+		GuidedBilateralLegacyFilter(dimx, dimy, 1, origPlane, origPlane, demisize, sscale, iscale, ipower, gscale, gpower, plane8.data());
+		for (int i = 0; i < plane; i++)
+			refII[i * nchan + c] = plane8[i];
+	}
+	GuidedBilateralLegacyFilter(dimx, dimy, ncol, origPlanes.data(), guidePlanes.data(), demisize, sscale, iscale, ipower, gscale, gpower, refPlanar.data());
+	for (int i = 0; i < plane; i++)
+		refStep[i] = (float)origPlanes[i];
+	GuidedBilateralLegacyStep(dimx, dimy, ncol, origPlanes.data(), guidePlanes.data(), demisize, sscale, iscale, ipower, gscale, gpower, refStep.data());
+
+	// the legacy robust, bilateral and joint / cross filters of the first plane, the last one guided by ncol planes
+	const GuidedBilateralPolicy policies[3] = {GBF_POLICY_ROBUST, GBF_POLICY_BILATERAL, GBF_POLICY_JOINTCROSS};
+	std::vector<unsigned char> refPolicy(3 * plane);
+	GuidedBilateralLegacyRobust(dimx, dimy, origPlanes.data(), demisize, sscale, iscale, ipower, refPolicy.data());
+	GuidedBilateralLegacyBilateral(dimx, dimy, origPlanes.data(), demisize, sscale, iscale, refPolicy.data() + plane);
+	GuidedBilateralLegacyJointCross(dimx, dimy, ncol, origPlanes.data(), guidePlanes.data(), demisize, sscale, gscale, refPolicy.data() + 2 * plane);
+
+	GuidedBilateralTables tables, policyTables[3];
+	if (!GuidedBilateralBuildTables(demisize, sscale, iscale, ipower, gscale, gpower, &tables))
+		return (1);
+	for (int p = 0; p < 3; p++)
+		if (!GuidedBilateralBuildPolicyTables(policies[p], demisize, sscale, iscale, ipower, gscale, gpower, &policyTables[p]))
+			return (1);
+	GuidedBilateralFixedTables *fixedTables = new GuidedBilateralFixedTables;
+	const bool fixed = GuidedBilateralBuildFixedTables(&tables, fixedTables) != 0;
+
+	const GuidedBilateralKernel kernel0 = GuidedBilateralGetKernel();
+	const int tileBytes0 = GuidedBilateralGetTileBytes();
+	std::vector<unsigned char> resultIJ(2 * size), resultII(2 * size), weights, pyramid(GuidedBilateralPyramidBytes(dimx, dimy, nchan, 1));
+	std::vector<unsigned char> rowsIJ(size), rowsII(size);
+	std::vector<float> scratch(4 * (size_t)size);
+	float maxDiff, maxDiffII;
+	double psnr, psnrII;
+
+	// every kernel gives the bits of the scalar one, the first to run
+	std::vector<std::vector<unsigned char>> scalarResults(GBF_VERIFY_VARIANTS);
+	auto scalar = [&](int variant, void const *result, size_t bytes, size_t offset)
+	{
+		std::vector<unsigned char> &bits = scalarResults[variant];
+		if (bits.size() < offset + bytes)
+		{
+			bits.resize(offset + bytes);
+			memcpy(bits.data() + offset, result, bytes);
+			return true;
+		}
+		return memcmp(bits.data() + offset, result, bytes) == 0;
+	};
+	auto single = [&](const char *kernel, const char *variantName, void const *result, size_t bytes)
+	{
+		const int variant = GuidedBilateralVerifyVariant(variantName);
+		failures += GuidedBilateralVerifyReport(out, name, kernel, variant, maxDiff, psnr, scalar(variant, result, bytes, 0));
+	};
+	// the fused results against both references, the worse of the two reported
+	auto dual = [&](const char *kernel, const char *variantName, unsigned char const *ij, unsigned char const *ii)
+	{
+		const int variant = GuidedBilateralVerifyVariant(variantName);
+		GuidedBilateralVerifyCompare(size, ij, refIJ.data(), maxDiff, psnr);
+		GuidedBilateralVerifyCompare(size, ii, refII.data(), maxDiffII, psnrII);
+		const bool same = scalar(variant, ij, size, 0) && scalar(variant, ii, size, size);
+		failures += GuidedBilateralVerifyReport(out, name, kernel, variant, maxDiff > maxDiffII ? maxDiff : maxDiffII, psnr < psnrII ? psnr : psnrII, same);
+	};
+
+	for (int k = 0; k < GBF_KERNEL_COUNT; k++)
+	{
+		if (!GuidedBilateralSetKernel((GuidedBilateralKernel)k))
+			continue;
+		const char *kernel = GuidedBilateralKernelName((GuidedBilateralKernel)k);
+		GuidedBilateralSetTileBytes(tileBytes0);
+
+		for (int i = 0; i < plane; i++)
+			step[i] = (float)origPlanes[i];
+		GuidedBilateralFilterStep(dimx, dimy, ncol, origPlanes.data(), guidePlanes.data(), demisize, sscale, iscale, ipower, gscale, gpower, step.data());
+		GuidedBilateralVerifyCompare(plane, step.data(), refStep.data(), maxDiff, psnr);
+		single(kernel, "step", step.data(), plane * sizeof(float));
+
+		GuidedBilateralFilter(dimx, dimy, ncol, origPlanes.data(), guidePlanes.data(), demisize, sscale, iscale, ipower, gscale, gpower, plane8.data());
+		GuidedBilateralVerifyCompare(plane, plane8.data(), refPlanar.data(), maxDiff, psnr);
+		single(kernel, "filter", plane8.data(), plane);
+
+		GuidedBilateralFilterInterleaved(dimx, dimy, nchan, orig, guide, demisize, sscale, iscale, ipower, gscale, gpower, resultIJ.data());
+		GuidedBilateralVerifyCompare(size, resultIJ.data(), refIJ.data(), maxDiff, psnr);
+		single(kernel, "interleaved", resultIJ.data(), size);
+
+		for (int p = 0; p < 3; p++)
+		{
+			unsigned char const *policyGuide = policies[p] == GBF_POLICY_JOINTCROSS ? guidePlanes.data() : origPlanes.data();
+			GuidedBilateralFilterTables(dimx, dimy, policies[p] == GBF_POLICY_JOINTCROSS ? ncol : 1, origPlanes.data(), policyGuide, &policyTables[p], plane8.data());
+			GuidedBilateralVerifyCompare(plane, plane8.data(), refPolicy.data() + p * plane, maxDiff, psnr);
+			single(kernel, GuidedBilateralPolicyName(policies[p]), plane8.data(), plane);
+		}
+
+		// rows, tiles of whole rows, tiles cut in columns
+		const int tiles[3] = {0, tileBytes0, 4096};
+		const char *tileVariants[3] = {"dual_rows", "dual_tiles", "dual_column_tiles"};
+		for (int t = 0; t < 3; t++)
+		{
+			GuidedBilateralSetTileBytes(tiles[t]);
+			GuidedBilateralFilterDual(dimx, dimy, nchan, orig, guide, demisize, sscale, iscale, ipower, gscale, gpower, resultIJ.data(), resultII.data());
+			dual(kernel, tileVariants[t], resultIJ.data(), resultII.data());
+			if (t == 0)
+			{
+				memcpy(rowsIJ.data(), resultIJ.data(), size);
+				memcpy(rowsII.data(), resultII.data(), size);
+			}
+		}
+		GuidedBilateralSetTileBytes(tileBytes0);
+
+		// the pre-screen of 8 x 8 tiles against the exact comparison, at thresholds low enough to skip and to filter
+		float excess = 0.0f;
+		for (int threshold = 10; threshold <= 90; threshold += 40)
+			for (int j0 = 0; j0 < dimy; j0 += 8)
+				for (int i0 = 0; i0 < dimx; i0 += 8)
+				{
+					const int j1 = j0 + 8 < dimy ? j0 + 8 : dimy, i1 = i0 + 8 < dimx ? i0 + 8 : dimx;
+					if (!GuidedBilateralScreenTile(dimx, dimy, nchan, orig, dimx * nchan, guide, dimx * nchan, &tables, threshold, j0, j1, i0, i1))
+						continue;
+					for (int j = j0; j < j1; j++)
+						for (int i = i0 * nchan; i < i1 * nchan; i++)
+						{
+							const float over = (float)abs(resultII[j * dimx * nchan + i] - resultIJ[j * dimx * nchan + i]) - (float)threshold;
+							excess = over > excess ? over : excess;
+						}
+				}
+		maxDiff = excess;
+		psnr = INFINITY;
+		failures += GuidedBilateralVerifyReport(out, name, kernel, GuidedBilateralVerifyVariant("screen"), maxDiff, psnr, true);
+
+		// the strips of GuidedBilateralStreamFilter: one row, demisize rows, an odd height and the whole image
+		const int stride = dimx * nchan;
+		const int stripHeights[4] = {1, demisize, 2 * demisize + 1, dimy};
+		for (int h = 0; h < 4; h++)
+		{
+			const int stripRows = stripHeights[h] < dimy ? stripHeights[h] : dimy;
+			for (int j0 = 0; j0 < dimy; j0 += stripRows)
+			{
+				const int j1 = j0 + stripRows < dimy ? j0 + stripRows : dimy;
+				const int top = j0 < demisize ? j0 : demisize;
+				const int bottom = dimy - j1 < demisize ? dimy - j1 : demisize;
+				GuidedBilateralFilterDualStrip(dimx, top + (j1 - j0) + bottom, nchan, orig + (j0 - top) * stride, stride, guide + (j0 - top) * stride, stride,
+											   top, j1 - j0, &tables, scratch.data(), resultIJ.data() + j0 * stride, stride, resultII.data() + j0 * stride, stride);
+			}
+			const int variant = GuidedBilateralVerifyVariant("strip");
+			GuidedBilateralVerifyCompare(size, resultIJ.data(), rowsIJ.data(), maxDiff, psnr);
+			GuidedBilateralVerifyCompare(size, resultII.data(), rowsII.data(), maxDiffII, psnrII);
+			const bool same = scalar(variant, resultIJ.data(), size, 0) && scalar(variant, resultII.data(), size, size);
+			failures += GuidedBilateralVerifyReport(out, name, kernel, variant, maxDiff > maxDiffII ? maxDiff : maxDiffII, psnr < psnrII ? psnr : psnrII, same);
+		}
+
+		// the pair twice in one batch
+		GuidedBilateralPair pairs[2] = {{dimx, dimy, orig, guide, resultIJ.data(), resultII.data(), NULL, stride, stride, stride, stride},
+										{dimx, dimy, orig, guide, resultIJ.data() + size, resultII.data() + size, NULL, stride, stride, stride, stride}};
+		GuidedBilateralFilterDualBatch(2, pairs, nchan, &tables, scratch.data());
+		for (int p = 0; p < 2; p++)
+			dual(kernel, "batch", resultIJ.data() + p * size, resultII.data() + p * size);
+
+		// views into larger images, every row padded by a different amount
+		const int origStride = stride + nchan + 1, guideStride = stride + 3, resultStride = stride + 2 * nchan;
+		std::vector<unsigned char> origView((size_t)origStride * dimy), guideView((size_t)guideStride * dimy);
+		std::vector<unsigned char> ijView((size_t)resultStride * dimy), iiView((size_t)resultStride * dimy);
+		for (int j = 0; j < dimy; j++)
+		{
+			memcpy(origView.data() + j * origStride, orig + j * stride, stride);
+			memcpy(guideView.data() + j * guideStride, guide + j * stride, stride);
+		}
+		GuidedBilateralFilterDualScratch(dimx, dimy, nchan, origView.data(), origStride, guideView.data(), guideStride, &tables, scratch.data(),
+										 ijView.data(), resultStride, iiView.data(), resultStride);
+		for (int j = 0; j < dimy; j++)
+		{
+			memcpy(resultIJ.data() + j * stride, ijView.data() + j * resultStride, stride);
+			memcpy(resultII.data() + j * stride, iiView.data() + j * resultStride, stride);
+		}
+		dual(kernel, "strided", resultIJ.data(), resultII.data());
+
+		const GuidedBilateralPrecision precisions[3] = {GBF_STATIC_F32, GBF_STATIC_F16, GBF_STATIC_U8};
+		const char *staticVariants[3] = {"static_f32", "static_f16", "static_u8"};
+		for (int p = 0; p < 3; p++)
+		{
+			weights.resize(GuidedBilateralStaticBytes(dimx, dimy, nchan, demisize, precisions[p]));
+			GuidedBilateralFilterDualScratch(dimx, dimy, nchan, orig, stride, guide, stride, &tables, scratch.data(), resultIJ.data(), stride,
+											 resultII.data(), stride, NULL, precisions[p], weights.data());
+			dual(kernel, staticVariants[p], resultIJ.data(), resultII.data());
+		}
+
+		if (fixed)
+		{
+			GuidedBilateralFilterDualFixedScratch(dimx, dimy, nchan, orig, stride, guide, stride, &tables, fixedTables, (unsigned short *)scratch.data(),
+												  resultIJ.data(), stride, resultII.data(), stride);
+			dual(kernel, "fixed", resultIJ.data(), resultII.data());
+		}
+
+		GuidedBilateralFilterDualPyramid(dimx, dimy, nchan, orig, stride, guide, stride, &tables, 1, scratch.data(), pyramid.data(),
+										 resultIJ.data(), stride, resultII.data(), stride);
+		dual(kernel, "pyramid", resultIJ.data(), resultII.data());
+	}
+
+	GuidedBilateralSetKernel(kernel0);
+	GuidedBilateralSetTileBytes(tileBytes0);
+	delete fixedTables;
+	GuidedBilateralFreeTables(&tables);
+	for (int p = 0; p < 3; p++)
+		GuidedBilateralFreeTables(&policyTables[p]);
+
+	return failures;
+}
+
+// smooth random orig, its guide an illumination change of it with noise and a few unrelated pixels
+static unsigned int GuidedBilateralVerifyNext(unsigned int &state)
+{
+	state = state * 1664525u + 1013904223u;
+	return state >> 8;
+}
+
+int GuidedBilateralVerifyRandom(FILE *out, unsigned int seed)
+{
+	static const int sizes[][2] = {{1, 1}, {3, 7}, {17, 5}, {67, 64}, {131, 77}};
+	static const int channels[] = {1, 3, 4};
+	static const GuidedBilateralVerifyParams schedules[] = {{1, 1.5f, 10.0f, 0.0f, 10.0f, 1.0f},
+															{2, 1.5f, 10.0f, 0.0f, 10.0f, 1.0f},
+															{3, 2.0f, 20.0f, 0.5f, 5.0f, 0.0f},
+															{2, 1.5f, 10.0f, 1.5f, 10.0f, 1.0f},
+															// ipower 2, intensity weights up to 2600, out of Q15 unless the fixed tables rescale
+															{2, 1.5f, 5.0f, 2.0f, 10.0f, 1.0f}};
+	unsigned int state = seed;
+	int failures = 0;
+	char name[64];
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+		for (size_t c = 0; c < sizeof(channels) / sizeof(channels[0]); c++)
+			for (size_t p = 0; p < sizeof(schedules) / sizeof(schedules[0]); p++)
+			{
+				const int dimx = sizes[s][0], dimy = sizes[s][1], nchan = channels[c], size = dimx * dimy * nchan;
+				std::vector<unsigned char> orig(size), guide(size);
+				for (int i = 0; i < size; i++)
+				{
+					const int smooth = (int)((i / nchan) % dimx * 255 / dimx) + (int)(GuidedBilateralVerifyNext(state) % 40) - 20;
+					orig[i] = (unsigned char)(smooth < 0 ? 0 : smooth > 255 ? 255 : smooth);
+					const int lit = orig[i] * 3 / 4 + 30 + (int)(GuidedBilateralVerifyNext(state) % 9) - 4;
+					guide[i] = GuidedBilateralVerifyNext(state) % 16 ? (unsigned char)lit : (unsigned char)(GuidedBilateralVerifyNext(state) % 256);
+				}
+				snprintf(name, sizeof(name), "random %dx%dx%d r%d p%d", dimx, dimy, nchan, schedules[p].demisize, (int)p);
+				failures += GuidedBilateralVerifyPair(out, name, dimx, dimy, nchan, orig.data(), guide.data(), schedules[p]);
+			}
+
+	return failures;
+}
@@ -0,0 +1,36 @@
+#ifndef CPU_VERIFY_H
+#define CPU_VERIFY_H
+
+#include <stdio.h>
+
+// Equivalence of the optimized filters with the legacy mex filter, legacy/guidedbilateralfilter_mex.c, run by
+// guidedbilateral_cpu --verify. Every variant of every kernel the cpu has filters the pair, the maximum absolute
+// difference and the psnr against the legacy filter are checked against the tolerance of the variant:
+// - exact, 0 difference: the single step, the planar, interleaved and fused filters, rows or tiles, the batch, the fused
+//   filter on views into larger images
+// - static_f32, static_f16, static_u8: the static weight planes
+// - fixed: the 8.8 fixed point filter
+// - screen: the tiles GuidedBilateralScreenTile skips, whose comparison must stay under the threshold
+// - pyramid: the warm-up steps on the half resolution level, its max and psnr are the cost of the approximation
+// - robust, bilateral, jointcross: the other legacy mex filters against their policies of the planar filter
+struct GuidedBilateralVerifyTolerance
+{
+	const char *variant;
+	float maxDiff;
+	double minPsnr;
+};
+
+struct GuidedBilateralVerifyParams
+{
+	int demisize;
+	float sscale, iscale, ipower, gscale, gpower;
+};
+
+// checks the interleaved pair of nchan channels, writes a line per variant and kernel to out, returns the failures
+int GuidedBilateralVerifyPair(FILE *out, const char *name, int dimx, int dimy, int nchan, unsigned char const *orig,
+							  unsigned char const *guide, const GuidedBilateralVerifyParams &params);
+
+// checks random pairs over sizes, channel counts, demisize and schedules, returns the failures
+int GuidedBilateralVerifyRandom(FILE *out, unsigned int seed);
+
+#endif
@@ -0,0 +1,219 @@
+#include "cpu_weights.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <new>
+
+#include "cpu_weights_default.h"
+
+// a table and its parameters, the spatial ones hold sweight then the window. demisize is 0 for the other kinds.
+struct GuidedBilateralWeightEntry
+{
+	float first, second;
+	int demisize;
+	float const *weights;
+	GuidedBilateralWeightEntry const *next;
+};
+
+// the default tables, the heads of the lists
+static constexpr GuidedBilateralWeightEntry spatialDefaults[2] = {
+	{1.5f, 0.0f, 2, GuidedBilateralSpatial15R2, &spatialDefaults[1]},
+	{0.0f, 0.0f, 2, GuidedBilateralSpatial0R2, NULL}};
+static constexpr GuidedBilateralWeightEntry intensityDefaults[3] = {
+	{10.0f, 0.0f, 0, GuidedBilateralIntensity10P0, &intensityDefaults[1]},
+	{10.0f, 0.5f, 0, GuidedBilateralIntensity10P05, &intensityDefaults[2]},
+	{10.0f, 1.0f, 0, GuidedBilateralIntensity10P1, NULL}};
+static constexpr GuidedBilateralWeightEntry guideDefaults[2] = {
+	{10.0f, 1.0f, 0, GuidedBilateralGuide10P1, &guideDefaults[1]},
+	{50.0f, 1.0f, 0, GuidedBilateralGuide50P1, NULL}};
+static constexpr GuidedBilateralWeightEntry gaussianDefaults[1] = {
+	{10.0f, 0.0f, 0, GuidedBilateralGaussian10, NULL}};
+
+// constant initialized, the lookups of static constructors in other files see the defaults
+static std::atomic<GuidedBilateralWeightEntry const *> spatialHead(&spatialDefaults[0]);
+static std::atomic<GuidedBilateralWeightEntry const *> intensityHead(&intensityDefaults[0]);
+static std::atomic<GuidedBilateralWeightEntry const *> guideHead(&guideDefaults[0]);
+static std::atomic<GuidedBilateralWeightEntry const *> gaussianHead(&gaussianDefaults[0]);
+static std::atomic<GuidedBilateralWeightEntry const *> constantHead(NULL);
+
+static void GuidedBilateralFillSpatial(float sscale, float, int demisize, float *weights)
+{
+	const int size = 2 * demisize + 1;
+	float *sweight = weights, *swindow = weights + demisize + 1;
+
+	for (int i = 0; i <= demisize; i++)
+	{
+		if (sscale > 0.0f)
+			sweight[i] = exp(-0.5f * (float)(i * i) / (sscale * sscale));
+		else
+			sweight[i] = 1.0f;
+	}
+	for (int k = -demisize; k <= demisize; k++)
+		for (int l = -demisize; l <= demisize; l++)
+			swindow[(k + demisize) * size + l + demisize] = sweight[abs(k)] * sweight[abs(l)];
+}
+
+static void GuidedBilateralFillIntensity(float iscale, float ipower, int, float *iweight)
+{
+	for (int i = 0; i <= 256; i++)
+	{
+		if (ipower != 1.0f)
+			iweight[i] = pow(1.0f + (float)(i * i) / (iscale * iscale), ipower - 1.0f);
+		else
+			iweight[i] = 1.0f;
+	}
+}
+
+static void GuidedBilateralFillGuide(float gscale, float gpower, int, float *gweight)
+{
+	for (int i = 0; i <= 255; i++)
+	{
+		if (gpower != 0.0f)
+			gweight[i] = exp(-(pow(1.0f + (float)(i * i) / (gscale * gscale), gpower) - 1.0f) / gpower);
+		else
+			gweight[i] = 1.0f / (1.0f + (float)(i * i) / (gscale * gscale));
+	}
+}
+
+static void GuidedBilateralFillGaussian(float scale, float, int, float *weights)
+{
+	for (int i = 0; i <= 256; i++)
+		weights[i] = exp(-0.5f * (float)(i * i) / (scale * scale));
+}
+
+static void GuidedBilateralFillConstant(float value, float, int, float *weights)
+{
+	for (int i = 0; i <= 256; i++)
+		weights[i] = value;
+}
+
+static inline bool GuidedBilateralSameKey(GuidedBilateralWeightEntry const *entry, float first, float second, int demisize)
+{
+	return memcmp(&entry->first, &first, sizeof(float)) == 0 && memcmp(&entry->second, &second, sizeof(float)) == 0 &&
+		   entry->demisize == demisize;
+}
+
+// the entries from top down to stop, excluded
+static GuidedBilateralWeightEntry const *GuidedBilateralFindWeights(GuidedBilateralWeightEntry const *top, GuidedBilateralWeightEntry const *stop,
+																	float first, float second, int demisize)
+{
+	for (GuidedBilateralWeightEntry const *entry = top; entry != stop; entry = entry->next)
+		if (GuidedBilateralSameKey(entry, first, second, demisize))
+			return entry;
+	return NULL;
+}
+
+static float const *GuidedBilateralCachedWeights(std::atomic<GuidedBilateralWeightEntry const *> &head, float first, float second, int demisize,
+												 int count, void (*fill)(float, float, int, float *))
+{
+	GuidedBilateralWeightEntry const *top = head.load(std::memory_order_acquire), *found;
+
+	if ((found = GuidedBilateralFindWeights(top, NULL, first, second, demisize)) != NULL)
+		return found->weights;
+
+	// built outside of any lock, a thread may build a table another one publishes first
+	float *weights = new (std::nothrow) float[count];
+	GuidedBilateralWeightEntry *entry = new (std::nothrow) GuidedBilateralWeightEntry;
+	if (weights == NULL || entry == NULL)
+	{
+		delete[] weights;
+		delete entry;
+		return NULL;
+	}
+	fill(first, second, demisize, weights);
+	entry->first = first;
+	entry->second = second;
+	entry->demisize = demisize;
+	entry->weights = weights;
+
+	// a failed swap reloads top, only the entries pushed since the last look can hold the key
+	GuidedBilateralWeightEntry const *seen = top;
+	for (;;)
+	{
+		entry->next = top;
+		if (head.compare_exchange_weak(top, entry, std::memory_order_acq_rel, std::memory_order_acquire))
+			return weights;
+		if ((found = GuidedBilateralFindWeights(top, seen, first, second, demisize)) != NULL)
+		{
+			delete[] weights;
+			delete entry;
+			return found->weights;
+		}
+		seen = top;
+	}
+}
+
+float const *GuidedBilateralSpatialWeights(float sscale, int demisize, float const **sweight)
+{
+	const int size = 2 * demisize + 1;
+	float const *weights = GuidedBilateralCachedWeights(spatialHead, sscale, 0.0f, demisize, demisize + 1 + size * size, GuidedBilateralFillSpatial);
+
+	if (weights == NULL)
+		return NULL;
+	if (sweight)
+		*sweight = weights;
+	return weights + demisize + 1;
+}
+
+float const *GuidedBilateralIntensityWeights(float iscale, float ipower)
+{
+	return GuidedBilateralCachedWeights(intensityHead, iscale, ipower, 0, 257, GuidedBilateralFillIntensity);
+}
+
+float const *GuidedBilateralGuideWeights(float gscale, float gpower)
+{
+	return GuidedBilateralCachedWeights(guideHead, gscale, gpower, 0, 256, GuidedBilateralFillGuide);
+}
+
+float const *GuidedBilateralGaussianWeights(float scale)
+{
+	return GuidedBilateralCachedWeights(gaussianHead, scale, 0.0f, 0, 257, GuidedBilateralFillGaussian);
+}
+
+float const *GuidedBilateralUnitWeights()
+{
+	// ipower 1 drops the intensity term
+	return GuidedBilateralIntensity10P1;
+}
+
+float const *GuidedBilateralConstantWeights(float value)
+{
+	return GuidedBilateralCachedWeights(constantHead, value, 0.0f, 0, 257, GuidedBilateralFillConstant);
+}
+
+int GuidedBilateralCheckDefaultWeights(FILE *out)
+{
+	struct
+	{
+		const char *name;
+		GuidedBilateralWeightEntry const *entry;
+		int count;
+		void (*fill)(float, float, int, float *);
+	} const defaults[] = {{"GuidedBilateralSpatial15R2", &spatialDefaults[0], 3 + 25, GuidedBilateralFillSpatial},
+						  {"GuidedBilateralSpatial0R2", &spatialDefaults[1], 3 + 25, GuidedBilateralFillSpatial},
+						  {"GuidedBilateralIntensity10P0", &intensityDefaults[0], 257, GuidedBilateralFillIntensity},
+						  {"GuidedBilateralIntensity10P05", &intensityDefaults[1], 257, GuidedBilateralFillIntensity},
+						  {"GuidedBilateralIntensity10P1", &intensityDefaults[2], 257, GuidedBilateralFillIntensity},
+						  {"GuidedBilateralGuide10P1", &guideDefaults[0], 256, GuidedBilateralFillGuide},
+						  {"GuidedBilateralGuide50P1", &guideDefaults[1], 256, GuidedBilateralFillGuide},
+						  {"GuidedBilateralGaussian10", &gaussianDefaults[0], 257, GuidedBilateralFillGaussian}};
+	float weights[257];
+	int failures = 0;
+
+	for (auto &d : defaults)
+	{
+		d.fill(d.entry->first, d.entry->second, d.entry->demisize, weights);
+		if (memcmp(weights, d.entry->weights, d.count * sizeof(float)) == 0)
+			continue;
+
+		failures++;
+		fprintf(out, "static constexpr float %s[%d] = {\n\t", d.name, d.count);
+		for (int i = 0; i < d.count; i++)
+			fprintf(out, "%s%af", i == 0 ? "" : i % 8 == 0 ? ",\n\t" : ", ", weights[i]);
+		fprintf(out, "};\n\n");
+	}
+
+	return failures;
+}
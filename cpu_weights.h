@@ -0,0 +1,32 @@
+#ifndef CPU_WEIGHTS_H
+#define CPU_WEIGHTS_H
+
+#include <stdio.h>
+
+// Process wide cache of the weight tables of a step, shared by every engine, filter and thread. A table is built once
+// per parameter set, the parameters are compared bit for bit, and never freed: the pointers stay valid until the
+// process exits. The lookups are lock free, a set met for the first time is built by the caller and published with
+// a compare and swap, the thread that loses a race takes the table of the winner. The tables of the default schedule,
+// GuidedBilateralSchedule(1.5, 10, 0, 10, 1) with demisize 2, and the gaussian of scale 10 are constexpr and never built.
+//
+// Each kind returns NULL if a new table cannot be allocated.
+
+// the (2 * demisize + 1)^2 spatial window sweight[|k|] * sweight[|l|], row by row. sweight, if not NULL, gets the
+// demisize + 1 one dimensional weights.
+float const *GuidedBilateralSpatialWeights(float sscale, int demisize, float const **sweight = NULL);
+// the 257 intensity weights of the differences 0 to 256, interpolated by the filters
+float const *GuidedBilateralIntensityWeights(float iscale, float ipower);
+// the 256 guide weights of the differences 0 to 255
+float const *GuidedBilateralGuideWeights(float gscale, float gpower);
+// the 257 gaussian weights exp(-0.5 i^2 / scale^2) of the legacy bilateral and joint / cross filters, intensity or guide
+float const *GuidedBilateralGaussianWeights(float scale);
+// 257 ones, the intensity or guide weights of a filter without that term
+float const *GuidedBilateralUnitWeights();
+// 257 times value, a term that scales every weight of a step
+float const *GuidedBilateralConstantWeights(float value);
+
+// checks the constexpr tables against the tables built at run time, writes the ones that differ to out in the form
+// of cpu_weights_default.h, returns their count
+int GuidedBilateralCheckDefaultWeights(FILE *out);
+
+#endif
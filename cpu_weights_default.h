@@ -0,0 +1,229 @@
+#ifndef CPU_WEIGHTS_DEFAULT_H
+#define CPU_WEIGHTS_DEFAULT_H
+
+// Weight tables of the default schedule, demisize 2, written by GuidedBilateralCheckDefaultWeights from the formulas
+// of cpu_weights.cpp built with -ffp-contract=off. guidedbilateral_cpu --verify prints the tables that no longer
+// match the formulas, in this form. Spatial: sweight[0..2] then the 5 x 5 window, sscale 1.5 and 0 for the first
+// step. Intensity: iscale 10 and ipower 0, 0.5 and 1. Guide: gscale 10 and 50, gpower 1.
+// Gaussian: scale 10.
+
+static constexpr float GuidedBilateralSpatial15R2[28] = {
+	0x1p+0f, 0x1.99fa4p-1f, 0x1.a4fa9ep-2f, 0x1.5a23a6p-3f, 0x1.5117f6p-2f, 0x1.a4fa9ep-2f, 0x1.5117f6p-2f, 0x1.5a23a6p-3f,
+	0x1.5117f6p-2f, 0x1.4848cap-1f, 0x1.99fa4p-1f, 0x1.4848cap-1f, 0x1.5117f6p-2f, 0x1.a4fa9ep-2f, 0x1.99fa4p-1f, 0x1p+0f,
+	0x1.99fa4p-1f, 0x1.a4fa9ep-2f, 0x1.5117f6p-2f, 0x1.4848cap-1f, 0x1.99fa4p-1f, 0x1.4848cap-1f, 0x1.5117f6p-2f, 0x1.5a23a6p-3f,
+	0x1.5117f6p-2f, 0x1.a4fa9ep-2f, 0x1.5117f6p-2f, 0x1.5a23a6p-3f};
+
+static constexpr float GuidedBilateralSpatial0R2[28] = {
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f};
+
+static constexpr float GuidedBilateralIntensity10P0[257] = {
+	0x1p+0f, 0x1.faee42p-1f, 0x1.ec4ec6p-1f, 0x1.d5b98ap-1f, 0x1.b9611cp-1f, 0x1.99999ap-1f, 0x1.787878p-1f, 0x1.579fc8p-1f,
+	0x1.3831f4p-1f, 0x1.1adf78p-1f, 0x1p-1f, 0x1.cf5932p-2f, 0x1.a3ac1p-2f, 0x1.7cab4cp-2f, 0x1.59f22ap-2f, 0x1.3b13b2p-2f,
+	0x1.1fa3f4p-2f, 0x1.073d34p-2f, 0x1.e304d6p-3f, 0x1.bc406cp-3f, 0x1.99999ap-3f, 0x1.7a8ee8p-3f, 0x1.5eaf58p-3f, 0x1.4598ap-3f,
+	0x1.2ef564p-3f, 0x1.1a7b96p-3f, 0x1.07eae2p-3f, 0x1.ee16dap-4f, 0x1.cf5932p-4f, 0x1.b34818p-4f, 0x1.99999ap-4f, 0x1.820d08p-4f,
+	0x1.6c69aep-4f, 0x1.587dbcp-4f, 0x1.461d58p-4f, 0x1.3521dp-4f, 0x1.2568e4p-4f, 0x1.16d442p-4f, 0x1.0948f4p-4f, 0x1.f95dfap-5f,
+	0x1.e1e1e2p-5f, 0x1.cbf762p-5f, 0x1.b77c28p-5f, 0x1.a4517p-5f, 0x1.925b88p-5f, 0x1.818182p-5f, 0x1.71acd2p-5f, 0x1.62c91ep-5f,
+	0x1.54c3fp-5f, 0x1.478c8ap-5f, 0x1.3b13b2p-5f, 0x1.2f4b8ap-5f, 0x1.24277p-5f, 0x1.199bdap-5f, 0x1.0f9e38p-5f, 0x1.0624dep-5f,
+	0x1.fa4dd8p-6f, 0x1.e9387cp-6f, 0x1.d8faaep-6f, 0x1.c9869cp-6f, 0x1.bacf92p-6f, 0x1.acc9cep-6f, 0x1.9f6a74p-6f, 0x1.92a77cp-6f,
+	0x1.867796p-6f, 0x1.7ad22p-6f, 0x1.6faf1cp-6f, 0x1.650716p-6f, 0x1.5ad32p-6f, 0x1.510cccp-6f, 0x1.47ae14p-6f, 0x1.3eb16p-6f,
+	0x1.36117p-6f, 0x1.2dc964p-6f, 0x1.25d4aap-6f, 0x1.1e2ef4p-6f, 0x1.16d442p-6f, 0x1.0fc0dp-6f, 0x1.08f118p-6f, 0x1.0261c8p-6f,
+	0x1.f81f82p-7f, 0x1.ebf02ap-7f, 0x1.e03006p-7f, 0x1.d4d9dep-7f, 0x1.c9e8d2p-7f, 0x1.bf583ep-7f, 0x1.b523cap-7f, 0x1.ab4756p-7f,
+	0x1.a1befcp-7f, 0x1.988712p-7f, 0x1.8f9c18p-7f, 0x1.86fac8p-7f, 0x1.7e9ffcp-7f, 0x1.7688c4p-7f, 0x1.6eb24ep-7f, 0x1.6719f4p-7f,
+	0x1.5fbd2ap-7f, 0x1.58999p-7f, 0x1.51acd8p-7f, 0x1.4af4dap-7f, 0x1.446f86p-7f, 0x1.3e1ae4p-7f, 0x1.37f514p-7f, 0x1.31fc52p-7f,
+	0x1.2c2ee6p-7f, 0x1.268b38p-7f, 0x1.210fb8p-7f, 0x1.1bbaeep-7f, 0x1.168b72p-7f, 0x1.117feep-7f, 0x1.0c9714p-7f, 0x1.07cfbp-7f,
+	0x1.032892p-7f, 0x1.fd413ap-8f, 0x1.f46d76p-8f, 0x1.ebd3dp-8f, 0x1.e3724ap-8f, 0x1.db4704p-8f, 0x1.d3502cp-8f, 0x1.cb8c0ap-8f,
+	0x1.c3f8fp-8f, 0x1.bc9548p-8f, 0x1.b55f8ap-8f, 0x1.ae563ep-8f, 0x1.a777f6p-8f, 0x1.a0c35cp-8f, 0x1.9a372p-8f, 0x1.93d202p-8f,
+	0x1.8d92ccp-8f, 0x1.877854p-8f, 0x1.818182p-8f, 0x1.7bad3ep-8f, 0x1.75fa82p-8f, 0x1.70684ep-8f, 0x1.6af5aep-8f, 0x1.65a1b4p-8f,
+	0x1.606b7cp-8f, 0x1.5b522cp-8f, 0x1.5654fp-8f, 0x1.5172fap-8f, 0x1.4cab88p-8f, 0x1.47fddap-8f, 0x1.436936p-8f, 0x1.3eececp-8f,
+	0x1.3a8854p-8f, 0x1.363ac6p-8f, 0x1.3203a2p-8f, 0x1.2de24ep-8f, 0x1.29d636p-8f, 0x1.25dec8p-8f, 0x1.21fb78p-8f, 0x1.1e2bc2p-8f,
+	0x1.1a6f2p-8f, 0x1.16c514p-8f, 0x1.132d26p-8f, 0x1.0fa6dep-8f, 0x1.0c31c8p-8f, 0x1.08cd78p-8f, 0x1.057982p-8f, 0x1.02357ap-8f,
+	0x1.fe01fep-9f, 0x1.f7b75cp-9f, 0x1.f18a4cp-9f, 0x1.eb7a1cp-9f, 0x1.e58618p-9f, 0x1.dfad8ep-9f, 0x1.d9efdcp-9f, 0x1.d44c5ap-9f,
+	0x1.cec27p-9f, 0x1.c9517ep-9f, 0x1.c3f8fp-9f, 0x1.beb838p-9f, 0x1.b98ec8p-9f, 0x1.b47c16p-9f, 0x1.af7fap-9f, 0x1.aa98e4p-9f,
+	0x1.a5c762p-9f, 0x1.a10aa4p-9f, 0x1.9c6234p-9f, 0x1.97cd98p-9f, 0x1.934c68p-9f, 0x1.8ede34p-9f, 0x1.8a829p-9f, 0x1.863914p-9f,
+	0x1.820164p-9f, 0x1.7ddb16p-9f, 0x1.79c5cep-9f, 0x1.75c12ep-9f, 0x1.71ccdcp-9f, 0x1.6de884p-9f, 0x1.6a13cep-9f, 0x1.664e64p-9f,
+	0x1.6297fap-9f, 0x1.5ef03ep-9f, 0x1.5b56e4p-9f, 0x1.57cbap-9f, 0x1.544e2ap-9f, 0x1.50de3ap-9f, 0x1.4d7b8cp-9f, 0x1.4a25dap-9f,
+	0x1.46dce4p-9f, 0x1.43a066p-9f, 0x1.407026p-9f, 0x1.3d4be6p-9f, 0x1.3a3366p-9f, 0x1.37267p-9f, 0x1.3424cap-9f, 0x1.312e3ap-9f,
+	0x1.2e428ap-9f, 0x1.2b618ap-9f, 0x1.288b02p-9f, 0x1.25becp-9f, 0x1.22fc92p-9f, 0x1.204448p-9f, 0x1.1d95b6p-9f, 0x1.1af0aap-9f,
+	0x1.1854fap-9f, 0x1.15c278p-9f, 0x1.1338fcp-9f, 0x1.10b858p-9f, 0x1.0e4066p-9f, 0x1.0bd0fcp-9f, 0x1.0969f6p-9f, 0x1.070b2ap-9f,
+	0x1.04b474p-9f, 0x1.0265b2p-9f, 0x1.001ebcp-9f, 0x1.fbbee4p-10f, 0x1.f74f5cp-10f, 0x1.f2eeaap-10f, 0x1.ee9c8p-10f, 0x1.ea58a4p-10f,
+	0x1.e622d4p-10f, 0x1.e1fad4p-10f, 0x1.dde06ap-10f, 0x1.d9d358p-10f, 0x1.d5d366p-10f, 0x1.d1e05cp-10f, 0x1.cdfa02p-10f, 0x1.ca202p-10f,
+	0x1.c65286p-10f, 0x1.c290fcp-10f, 0x1.bedb4ep-10f, 0x1.bb315p-10f, 0x1.b792ccp-10f, 0x1.b3ff94p-10f, 0x1.b0777ap-10f, 0x1.acfa4cp-10f,
+	0x1.a987e4p-10f, 0x1.a6201p-10f, 0x1.a2c2a8p-10f, 0x1.9f6f82p-10f, 0x1.9c2674p-10f, 0x1.98e75p-10f, 0x1.95b1f8p-10f, 0x1.92863ep-10f,
+	0x1.8f63fep-10f};
+
+static constexpr float GuidedBilateralIntensity10P05[257] = {
+	0x1p+0f, 0x1.fd7584p-1f, 0x1.f60eacp-1f, 0x1.ea6834p-1f, 0x1.db614cp-1f, 0x1.c9f25cp-1f, 0x1.b7095p-1f, 0x1.a3725ep-1f,
+	0x1.8fce0ap-1f, 0x1.7c910ep-1f, 0x1.6a09e6p-1f, 0x1.586892p-1f, 0x1.47c64p-1f, 0x1.382c02p-1f, 0x1.29980ep-1f, 0x1.1c01aap-1f,
+	0x1.0f5c06p-1f, 0x1.039824p-1f, 0x1.f14c62p-2f, 0x1.dceca4p-2f, 0x1.c9f25cp-2f, 0x1.b84082p-2f, 0x1.a7bbf6p-2f, 0x1.984ba8p-2f,
+	0x1.89d89ep-2f, 0x1.7c4dd6p-2f, 0x1.6f9836p-2f, 0x1.63a66p-2f, 0x1.586892p-2f, 0x1.4dd08p-2f, 0x1.43d136p-2f, 0x1.3a5efp-2f,
+	0x1.316fp-2f, 0x1.28f7b2p-2f, 0x1.20f036p-2f, 0x1.19507ep-2f, 0x1.12113cp-2f, 0x1.0b2bbcp-2f, 0x1.0499e4p-2f, 0x1.fcac38p-3f,
+	0x1.f0b684p-3f, 0x1.e54948p-3f, 0x1.da5bdep-3f, 0x1.cfe64ep-3f, 0x1.c5e148p-3f, 0x1.bc460ap-3f, 0x1.b30e5p-3f, 0x1.aa3458p-3f,
+	0x1.a1b2c4p-3f, 0x1.9984a2p-3f, 0x1.91a556p-3f, 0x1.8a1098p-3f, 0x1.82c26cp-3f, 0x1.7bb71ep-3f, 0x1.74eb36p-3f, 0x1.6e5b7ep-3f,
+	0x1.6804ecp-3f, 0x1.61e4bp-3f, 0x1.5bf828p-3f, 0x1.563cd6p-3f, 0x1.50b06ap-3f, 0x1.4b50b4p-3f, 0x1.461ba8p-3f, 0x1.410f58p-3f,
+	0x1.3c29f2p-3f, 0x1.3769c2p-3f, 0x1.32cd2ap-3f, 0x1.2e52a4p-3f, 0x1.29f8cp-3f, 0x1.25be24p-3f, 0x1.21a186p-3f, 0x1.1da1acp-3f,
+	0x1.19bd72p-3f, 0x1.15f3cp-3f, 0x1.12438cp-3f, 0x1.0eabdap-3f, 0x1.0b2bbcp-3f, 0x1.07c24ep-3f, 0x1.046ebap-3f, 0x1.01303p-3f,
+	0x1.fc0bd8p-4f, 0x1.f5de6cp-4f, 0x1.efd6b6p-4f, 0x1.e9f364p-4f, 0x1.e43334p-4f, 0x1.de94eep-4f, 0x1.d9176ep-4f, 0x1.d3b998p-4f,
+	0x1.ce7a64p-4f, 0x1.c958ccp-4f, 0x1.c453dap-4f, 0x1.bf6aa2p-4f, 0x1.ba9c44p-4f, 0x1.b5e7e6p-4f, 0x1.b14cb8p-4f, 0x1.acc9f4p-4f,
+	0x1.a85edap-4f, 0x1.a40ab4p-4f, 0x1.9fccd2p-4f, 0x1.9ba488p-4f, 0x1.979136p-4f, 0x1.93924p-4f, 0x1.8fa70ep-4f, 0x1.8bcf1p-4f,
+	0x1.8809bcp-4f, 0x1.84568ap-4f, 0x1.80b4fap-4f, 0x1.7d249p-4f, 0x1.79a4d4p-4f, 0x1.763554p-4f, 0x1.72d59cp-4f, 0x1.6f8546p-4f,
+	0x1.6c43e6p-4f, 0x1.69111ap-4f, 0x1.65ec8p-4f, 0x1.62d5bcp-4f, 0x1.5fcc74p-4f, 0x1.5cd05p-4f, 0x1.59e0fcp-4f, 0x1.56fe26p-4f,
+	0x1.54278p-4f, 0x1.515cbcp-4f, 0x1.4e9d92p-4f, 0x1.4be9bap-4f, 0x1.4940fp-4f, 0x1.46a2eep-4f, 0x1.440f74p-4f, 0x1.418646p-4f,
+	0x1.3f0724p-4f, 0x1.3c91d4p-4f, 0x1.3a261cp-4f, 0x1.37c3c4p-4f, 0x1.356a98p-4f, 0x1.331a64p-4f, 0x1.30d2f2p-4f, 0x1.2e9414p-4f,
+	0x1.2c5d96p-4f, 0x1.2a2f5p-4f, 0x1.28090ep-4f, 0x1.25eaa8p-4f, 0x1.23d3f2p-4f, 0x1.21c4c4p-4f, 0x1.1fbcf4p-4f, 0x1.1dbc5ap-4f,
+	0x1.1bc2d4p-4f, 0x1.19d038p-4f, 0x1.17e466p-4f, 0x1.15ff38p-4f, 0x1.14208ep-4f, 0x1.124844p-4f, 0x1.10763cp-4f, 0x1.0eaa58p-4f,
+	0x1.0ce474p-4f, 0x1.0b2476p-4f, 0x1.096a4p-4f, 0x1.07b5b6p-4f, 0x1.0606bcp-4f, 0x1.045d36p-4f, 0x1.02b90cp-4f, 0x1.011a22p-4f,
+	0x1.ff00cp-5f, 0x1.fbd75cp-5f, 0x1.f8b7e4p-5f, 0x1.f5a23p-5f, 0x1.f2961p-5f, 0x1.ef9356p-5f, 0x1.ec99dap-5f, 0x1.e9a96cp-5f,
+	0x1.e6c1ecp-5f, 0x1.e3e32ap-5f, 0x1.e10d02p-5f, 0x1.de3f4cp-5f, 0x1.db79e4p-5f, 0x1.d8bca6p-5f, 0x1.d6076cp-5f, 0x1.d35a16p-5f,
+	0x1.d0b47ep-5f, 0x1.ce1684p-5f, 0x1.cb800ap-5f, 0x1.c8f0eep-5f, 0x1.c6691p-5f, 0x1.c3e854p-5f, 0x1.c16e98p-5f, 0x1.befbcp-5f,
+	0x1.bc8fb4p-5f, 0x1.ba2a52p-5f, 0x1.b7cb82p-5f, 0x1.b57328p-5f, 0x1.b3212ap-5f, 0x1.b0d57p-5f, 0x1.ae8fdcp-5f, 0x1.ac505cp-5f,
+	0x1.aa16d2p-5f, 0x1.a7e32ap-5f, 0x1.a5b54ap-5f, 0x1.a38d1ep-5f, 0x1.a16a9p-5f, 0x1.9f4d88p-5f, 0x1.9d35fp-5f, 0x1.9b23b8p-5f,
+	0x1.9916c6p-5f, 0x1.970f08p-5f, 0x1.950c6cp-5f, 0x1.930edcp-5f, 0x1.911648p-5f, 0x1.8f229ap-5f, 0x1.8d33c2p-5f, 0x1.8b49aep-5f,
+	0x1.89644ap-5f, 0x1.87838ap-5f, 0x1.85a75ap-5f, 0x1.83cfa8p-5f, 0x1.81fc66p-5f, 0x1.802d82p-5f, 0x1.7e62fp-5f, 0x1.7c9c9ep-5f,
+	0x1.7ada7ep-5f, 0x1.791c7ep-5f, 0x1.776294p-5f, 0x1.75acbp-5f, 0x1.73fac4p-5f, 0x1.724cc2p-5f, 0x1.70a29ep-5f, 0x1.6efc46p-5f,
+	0x1.6d59b4p-5f, 0x1.6bbad6p-5f, 0x1.6a1fa2p-5f, 0x1.68880ap-5f, 0x1.66f402p-5f, 0x1.65638p-5f, 0x1.63d676p-5f, 0x1.624cdap-5f,
+	0x1.60c6ap-5f, 0x1.5f43bep-5f, 0x1.5dc428p-5f, 0x1.5c47d2p-5f, 0x1.5aceb4p-5f, 0x1.5958c4p-5f, 0x1.57e5f4p-5f, 0x1.56763cp-5f,
+	0x1.550994p-5f, 0x1.539ffp-5f, 0x1.523948p-5f, 0x1.50d592p-5f, 0x1.4f74c4p-5f, 0x1.4e16d4p-5f, 0x1.4cbbbcp-5f, 0x1.4b637p-5f,
+	0x1.4a0decp-5f, 0x1.48bb22p-5f, 0x1.476b0ep-5f, 0x1.461da4p-5f, 0x1.44d2ep-5f, 0x1.438ab6p-5f, 0x1.42452p-5f, 0x1.410216p-5f,
+	0x1.3fc192p-5f};
+
+static constexpr float GuidedBilateralIntensity10P1[257] = {
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f, 0x1p+0f,
+	0x1p+0f};
+
+static constexpr float GuidedBilateralGuide10P1[256] = {
+	0x1p+0f, 0x1.fae7dp-1f, 0x1.ebec9ap-1f, 0x1.d3eec8p-1f, 0x1.b44c32p-1f, 0x1.8ebefap-1f, 0x1.6535d4p-1f, 0x1.39aa2ap-1f,
+	0x1.0df946p-1f, 0x1.c788e2p-2f, 0x1.78b564p-2f, 0x1.315aap-2f, 0x1.e53a6p-3f, 0x1.79e55ep-3f, 0x1.207a6p-3f, 0x1.afb718p-4f,
+	0x1.3ca3e6p-4f, 0x1.c747cp-5f, 0x1.40d4a8p-5f, 0x1.bb37b6p-6f, 0x1.2c155cp-6f, 0x1.8e4d0ap-7f, 0x1.03192ap-7f, 0x1.4a6ab4p-8f,
+	0x1.9d05bcp-9f, 0x1.fa0e96p-10f, 0x1.2fe28ap-10f, 0x1.65bc86p-11f, 0x1.9ccab6p-12f, 0x1.d2e384p-13f, 0x1.02cf22p-13f, 0x1.193f98p-14f,
+	0x1.2b94c8p-15f, 0x1.38ca3cp-16f, 0x1.401d58p-17f, 0x1.411fbp-18f, 0x1.3bc1dep-19f, 0x1.30552cp-20f, 0x1.1f835ep-21f, 0x1.0a3eaep-22f,
+	0x1.e355bcp-24f, 0x1.ae07f6p-25f, 0x1.77078ep-26f, 0x1.409618p-27f, 0x1.0c9ebap-28f, 0x1.b93de2p-30f, 0x1.633894p-31f, 0x1.184eb6p-32f,
+	0x1.b1a01p-34f, 0x1.48c29ap-35f, 0x1.e8a37ap-37f, 0x1.63f15cp-38f, 0x1.fc4bcp-40f, 0x1.63be7ep-41f, 0x1.e817dcp-43f, 0x1.4835bep-44f,
+	0x1.b0a866p-46f, 0x1.178682p-47f, 0x1.62086ep-49f, 0x1.b78504p-51f, 0x1.0b6c3ap-52f, 0x1.3efab2p-54f, 0x1.74f0f6p-56f, 0x1.ab65d8p-58f,
+	0x1.e01b6ap-60f, 0x1.085194p-61f, 0x1.1d4606p-63f, 0x1.2dcb46p-65f, 0x1.38f2acp-67f, 0x1.3e16ep-69f, 0x1.3ce9bap-71f, 0x1.357d2p-73f,
+	0x1.2840ecp-75f, 0x1.15f80ep-77f, 0x1.ff4c6ap-80f, 0x1.ccee16p-82f, 0x1.974bfep-84f, 0x1.60c6bap-86f, 0x1.2b8122p-88f, 0x1.f27bd8p-91f,
+	0x1.969d48p-93f, 0x1.451bc6p-95f, 0x1.fd96ap-98f, 0x1.87770ap-100f, 0x1.26c4e4p-102f, 0x1.b31fc8p-105f, 0x1.3acbeep-107f, 0x1.be777cp-110f,
+	0x1.36564ep-112f, 0x1.a6e2fap-115f, 0x1.1a6baep-117f, 0x1.71c15ep-120f, 0x1.da8262p-123f, 0x1.2a7146p-125f, 0x1.6ff9bp-128f, 0x1.bcb9cp-131f,
+	0x1.076bp-133f, 0x1.31ep-136f, 0x1.5c4p-139f, 0x1.84p-142f, 0x1.bp-145f, 0x1p-147f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f};
+
+static constexpr float GuidedBilateralGuide50P1[256] = {
+	0x1p+0f, 0x1.ffcb96p-1f, 0x1.ff2e72p-1f, 0x1.fe28fep-1f, 0x1.fcbbd2p-1f, 0x1.fae7dp-1f, 0x1.f8ae16p-1f, 0x1.f61p-1f,
+	0x1.f30f26p-1f, 0x1.efad54p-1f, 0x1.ebec9ap-1f, 0x1.e7cf3p-1f, 0x1.e35792p-1f, 0x1.de8862p-1f, 0x1.d96474p-1f, 0x1.d3eec8p-1f,
+	0x1.ce2a9p-1f, 0x1.c81b1p-1f, 0x1.c1c3c4p-1f, 0x1.bb284p-1f, 0x1.b44c32p-1f, 0x1.ad3362p-1f, 0x1.a5e1bp-1f, 0x1.9e5b0ap-1f,
+	0x1.96a376p-1f, 0x1.8ebefap-1f, 0x1.86b1a8p-1f, 0x1.7e7f9cp-1f, 0x1.762ce4p-1f, 0x1.6dbd9ep-1f, 0x1.6535d4p-1f, 0x1.5c998ep-1f,
+	0x1.53ecc4p-1f, 0x1.4b3362p-1f, 0x1.427144p-1f, 0x1.39aa2ap-1f, 0x1.30e1c8p-1f, 0x1.281bacp-1f, 0x1.1f5b56p-1f, 0x1.16a42p-1f,
+	0x1.0df946p-1f, 0x1.055de4p-1f, 0x1.f9a9e6p-2f, 0x1.e8c298p-2f, 0x1.d80b38p-2f, 0x1.c788e2p-2f, 0x1.b74058p-2f, 0x1.a7361ep-2f,
+	0x1.976e5cp-2f, 0x1.87eceep-2f, 0x1.78b564p-2f, 0x1.69caf8p-2f, 0x1.5b309cp-2f, 0x1.4ce8eep-2f, 0x1.3ef644p-2f, 0x1.315aap-2f,
+	0x1.2417c6p-2f, 0x1.172f26p-2f, 0x1.0aa1f2p-2f, 0x1.fce228p-3f, 0x1.e53a6p-3f, 0x1.ce4d64p-3f, 0x1.b81b84p-3f, 0x1.a2a4a8p-3f,
+	0x1.8de84p-3f, 0x1.79e55ep-3f, 0x1.669aa2p-3f, 0x1.540664p-3f, 0x1.42268ep-3f, 0x1.30f8c4p-3f, 0x1.207a6p-3f, 0x1.10a87ep-3f,
+	0x1.017ff2p-3f, 0x1.e5fabap-4f, 0x1.ca3a4cp-4f, 0x1.afb718p-4f, 0x1.966958p-4f, 0x1.7e48f2p-4f, 0x1.674d96p-4f, 0x1.516ec4p-4f,
+	0x1.3ca3e6p-4f, 0x1.28e43p-4f, 0x1.1626cep-4f, 0x1.0462e2p-4f, 0x1.e71f1p-5f, 0x1.c747cp-5f, 0x1.a92e28p-5f, 0x1.8cc0aep-5f,
+	0x1.71ee0ap-5f, 0x1.58a5p-5f, 0x1.40d4a8p-5f, 0x1.2a6c68p-5f, 0x1.155bf2p-5f, 0x1.01935cp-5f, 0x1.de0618p-6f, 0x1.bb37b6p-6f,
+	0x1.9a9decp-6f, 0x1.7c1c1cp-6f, 0x1.5f9694p-6f, 0x1.44f254p-6f, 0x1.2c155cp-6f, 0x1.14e6bp-6f, 0x1.fe9c5cp-7f, 0x1.d66958p-7f,
+	0x1.b107c8p-7f, 0x1.8e4d0ap-7f, 0x1.6e1056p-7f, 0x1.502abcp-7f, 0x1.3477p-7f, 0x1.1ad1b6p-7f, 0x1.03192ap-7f, 0x1.da5abep-8f,
+	0x1.b1dfd2p-8f, 0x1.8c87fcp-8f, 0x1.6a1cccp-8f, 0x1.4a6ab4p-8f, 0x1.2d411cp-8f, 0x1.127238p-8f, 0x1.f3a5a6p-9f, 0x1.c674d6p-9f,
+	0x1.9d05bcp-9f, 0x1.7710e6p-9f, 0x1.54534cp-9f, 0x1.348e3cp-9f, 0x1.17872p-9f, 0x1.fa0e96p-10f, 0x1.c9b758p-10f, 0x1.9da978p-10f,
+	0x1.758c9p-10f, 0x1.510e56p-10f, 0x1.2fe28ap-10f, 0x1.11c264p-10f, 0x1.ecd882p-11f, 0x1.bb472p-11f, 0x1.8e604cp-11f, 0x1.65bc86p-11f,
+	0x1.40fc62p-11f, 0x1.1fc7b4p-11f, 0x1.01cda6p-11f, 0x1.cd873ep-12f, 0x1.9ccab6p-12f, 0x1.70e814p-12f, 0x1.496c56p-12f, 0x1.25ee3ep-12f,
+	0x1.060d58p-12f, 0x1.d2e384p-13f, 0x1.9f963p-13f, 0x1.71a02p-13f, 0x1.487c2ap-13f, 0x1.23b09ap-13f, 0x1.02cf22p-13f, 0x1.cae704p-14f,
+	0x1.96859ep-14f, 0x1.67d514p-14f, 0x1.3e4016p-14f, 0x1.193f98p-14f, 0x1.f0b318p-15f, 0x1.b63f8p-15f, 0x1.825da8p-15f, 0x1.545a86p-15f,
+	0x1.2b94c8p-15f, 0x1.077b6cp-15f, 0x1.cf1862p-16f, 0x1.96a44ap-16f, 0x1.64c8dep-16f, 0x1.38ca3cp-16f, 0x1.12004ep-16f, 0x1.dfa942p-17f,
+	0x1.a381aep-17f, 0x1.6e9a56p-17f, 0x1.401d58p-17f, 0x1.174c54p-17f, 0x1.e6fb54p-18f, 0x1.a83598p-18f, 0x1.713b84p-18f, 0x1.411fbp-18f,
+	0x1.170f5cp-18f, 0x1.e49fdp-19f, 0x1.a4786p-19f, 0x1.6c8474p-19f, 0x1.3bc1dep-19f, 0x1.114d16p-19f, 0x1.d8ba6cp-20f, 0x1.988304p-20f,
+	0x1.60bc7cp-20f, 0x1.30552cp-20f, 0x1.065c66p-20f, 0x1.c3fe5ap-21f, 0x1.8508dcp-21f, 0x1.4e93d6p-21f, 0x1.1f835ep-21f, 0x1.edbe4cp-22f,
+	0x1.a79c6cp-22f, 0x1.6b2658p-22f, 0x1.37119cp-22f, 0x1.0a3eaep-22f, 0x1.c764d8p-23f, 0x1.852636p-23f, 0x1.4c467cp-23f, 0x1.1b7c5ap-23f,
+	0x1.e355bcp-24f, 0x1.9bb4bap-24f, 0x1.5e697ep-24f, 0x1.2a0132p-24f, 0x1.fa7734p-25f, 0x1.ae07f6p-25f, 0x1.6cd6e6p-25f, 0x1.354868p-25f,
+	0x1.05fa2ep-25f, 0x1.bb754ap-26f, 0x1.77078ep-26f, 0x1.3ce7eap-26f, 0x1.0b937cp-26f, 0x1.c37d34p-27f, 0x1.7c99e2p-27f, 0x1.409618p-27f,
+	0x1.0dd1b6p-27f, 0x1.c5d1aep-28f, 0x1.7d57c4p-28f, 0x1.402f46p-28f, 0x1.0c9ebap-28f, 0x1.c25bfep-29f, 0x1.7939f4p-29f, 0x1.3bb788p-29f,
+	0x1.080682p-29f, 0x1.b93de2p-30f, 0x1.70688ap-30f, 0x1.3359fap-30f, 0x1.003574p-30f, 0x1.aacf7p-31f, 0x1.633894p-31f, 0x1.27671ap-31f,
+	0x1.eaec42p-32f, 0x1.9799ccp-32f, 0x1.522646p-32f, 0x1.184eb6p-32f, 0x1.d0590ep-33f, 0x1.804de2p-33f, 0x1.3dcdc2p-33f, 0x1.0699c2p-33f,
+	0x1.b1a01p-34f, 0x1.65bb14p-34f, 0x1.26e244p-34f, 0x1.e5c446p-35f, 0x1.8fc92ep-35f, 0x1.48c29ap-35f, 0x1.0e230cp-35f, 0x1.bb9426p-36f,
+	0x1.6be60cp-36f, 0x1.2a4bp-36f, 0x1.e8a37ap-37f, 0x1.8fe758p-37f, 0x1.470548p-37f, 0x1.0b34fcp-37f, 0x1.b45142p-38f, 0x1.63f15cp-38f};
+static constexpr float GuidedBilateralGaussian10[257] = {
+	0x1p+0f, 0x1.fd7246p-1f, 0x1.f5dc9ap-1f, 0x1.e9788p-1f, 0x1.d8a2b4p-1f, 0x1.c3d6a2p-1f, 0x1.aba88ap-1f, 0x1.90bea6p-1f,
+	0x1.73c9cep-1f, 0x1.557dfcp-1f, 0x1.368b3p-1f, 0x1.17971p-1f, 0x1.f26f2ep-2f, 0x1.b7dde2p-2f, 0x1.80518ep-2f, 0x1.4c71b2p-2f,
+	0x1.1cb5dp-2f, 0x1.e2ced6p-3f, 0x1.954beap-3f, 0x1.50d7fep-3f, 0x1.152aaap-3f, 0x1.c3961p-4f, 0x1.6c3912p-4f, 0x1.22d682p-4f,
+	0x1.cbdb1ep-5f, 0x1.67ee6ep-5f, 0x1.16eaaep-5f, 0x1.abf922p-6f, 0x1.451394p-6f, 0x1.e8eca2p-7f, 0x1.6c0504p-7f, 0x1.0c53dp-7f,
+	0x1.87a50ap-8f, 0x1.1af952p-8f, 0x1.94d812p-9f, 0x1.1eb806p-9f, 0x1.92144ap-10f, 0x1.171f44p-10f, 0x1.7facep-11f, 0x1.051272p-11f,
+	0x1.5fc21p-12f, 0x1.d53aa4p-13f, 0x1.35d9d2p-13f, 0x1.952466p-14f, 0x1.063beep-14f, 0x1.501792p-15f, 0x1.aa7746p-16f, 0x1.0be0dp-16f,
+	0x1.4d2dcp-17f, 0x1.9a464ap-18f, 0x1.f42ed4p-19f, 0x1.2ddcf8p-19f, 0x1.68ba08p-20f, 0x1.aac7ap-21f, 0x1.f3e75ap-22f, 0x1.21dd72p-22f,
+	0x1.4cce8ep-23f, 0x1.7a4eep-24f, 0x1.a9c08ap-25f, 0x1.da60a4p-26f, 0x1.05a628p-26f, 0x1.1dc286p-27f, 0x1.34fcacp-28f, 0x1.4ac714p-29f,
+	0x1.5e94ep-30f, 0x1.6fdfb4p-31f, 0x1.7e2d94p-32f, 0x1.8916a6p-33f, 0x1.90495ep-34f, 0x1.938fb2p-35f, 0x1.92d07ep-36f, 0x1.8e1172p-37f,
+	0x1.8576aap-38f, 0x1.7940dcp-39f, 0x1.69ca62p-40f, 0x1.57822cp-41f, 0x1.42e7d2p-42f, 0x1.2c8476p-43f, 0x1.14e62ep-44f, 0x1.f9325ap-46f,
+	0x1.c8465p-47f, 0x1.97fd5ap-48f, 0x1.692f5ep-49f, 0x1.3c914ep-50f, 0x1.12b392p-51f, 0x1.d7ffe2p-53f, 0x1.917796p-54f, 0x1.52137ep-55f,
+	0x1.19dcbap-56f, 0x1.d1509ep-58f, 0x1.7c4322p-59f, 0x1.33aa14p-60f, 0x1.ece5fap-62f, 0x1.86e65p-63f, 0x1.32ec46p-64f, 0x1.dd2dc8p-66f,
+	0x1.6f3f6ep-67f, 0x1.17d4dcp-68f, 0x1.a6334p-70f, 0x1.3b55p-71f, 0x1.d257d6p-73f, 0x1.556788p-74f, 0x1.eee74ap-76f, 0x1.6323dap-77f,
+	0x1.f89e5cp-79f, 0x1.62f0ecp-80f, 0x1.ee59ep-82f, 0x1.54d56ap-83f, 0x1.d14d7cp-85f, 0x1.3a7418p-86f, 0x1.a4c9cp-88f, 0x1.16bd44p-89f,
+	0x1.6d9c64p-91f, 0x1.dac932p-93f, 0x1.313676p-94f, 0x1.84815ap-96f, 0x1.e99b4ep-98f, 0x1.317046p-99f, 0x1.794cbcp-101f, 0x1.cd6ed6p-103f,
+	0x1.175afp-104f, 0x1.4ee1aap-106f, 0x1.8d73c6p-108f, 0x1.d304f4p-110f, 0x1.0fa698p-111f, 0x1.38e068p-113f, 0x1.64c676p-115f, 0x1.92c8c2p-117f,
+	0x1.c2336ap-119f, 0x1.f23104p-121f, 0x1.10e85cp-122f, 0x1.280528p-124f, 0x1.3de4fcp-126f, 0x1.51fd8p-128f, 0x1.63c7ap-130f, 0x1.72c78p-132f,
+	0x1.7e9p-134f, 0x1.86dp-136f, 0x1.8b4p-138f, 0x1.8b8p-140f, 0x1.88p-142f, 0x1.8p-144f, 0x1.8p-146f, 0x1.8p-148f,
+	0x1p-149f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f, 0x0p+0f,
+	0x0p+0f};
+
+#endif
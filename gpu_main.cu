@@ -7,9 +7,67 @@
 #include <string.h>
 #include <cmath>
 #include <chrono>
-#include <map>
 
-__global__ void bilateralKernel(int dimx, int dimy, int ncol, unsigned char *orig, unsigned char *guide, int demisize,
+#include "timing.h"
+#include "cpu_weights.h"
+
+// maximum channel count of the interleaved images
+#define GBF_MAX_NCHAN 4
+
+// Images are interleaved like cv::Mat, channel c of pixel (i, j) at (j * dimx + i) * nchan + c, each channel is
+// guided by the same channel of guide. filtered holds nchan float planes of dimx * dimy.
+// The neighbors are read from orig and guide, filtered only at the pixel being written: the in place update
+// gives the same result whatever order the blocks run in.
+// Border = false drops the bounds checks, only for pixels at least demisize away from the image border.
+template <bool Border>
+__device__ void bilateralPixel(int i, int j, int dimx, int dimy, int nchan, unsigned char *orig, unsigned char *guide, int demisize,
+							   float *sweight, float *iweight, float *gweight,
+							   float *filtered)
+{
+	int value, ediff, currentGuide[GBF_MAX_NCHAN], diffGuide;
+	float wguide, somme[GBF_MAX_NCHAN], poids, pixelMoy[GBF_MAX_NCHAN], currentIntensity[GBF_MAX_NCHAN], diff, rdiff;
+	const int plane = dimx * dimy;
+	for (int c = 0; c < nchan; c++)
+	{
+		somme[c] = 1e-6f;
+		pixelMoy[c] = 0.0f;
+		currentIntensity[c] = filtered[c * plane + j * dimx + i];
+		currentGuide[c] = guide[(j * dimx + i) * nchan + c];
+	}
+	// don't need to parallize here since only 2x2 max
+	for (int k = -demisize; k <= demisize; k++)
+	{
+		if (!Border || ((j + k >= 0) && (j + k < dimy)))
+		{
+			for (int l = -demisize; l <= demisize; l++)
+			{
+				if (!Border || ((i + l >= 0) && (i + l < dimx)))
+				{
+					// the three channels share the neighborhood traversal and the spatial weight
+					const int pixel = ((j + k) * dimx + i + l) * nchan;
+					const float wspatial = sweight[abs(k)] * sweight[abs(l)];
+					for (int c = 0; c < nchan; c++)
+					{
+						value = orig[pixel + c];
+						diff = fabs((float)value - currentIntensity[c]);
+						ediff = (int)floor(diff);
+						rdiff = diff - (float)ediff;
+						diffGuide = abs(guide[pixel + c] - currentGuide[c]);
+						wguide = gweight[diffGuide];
+						poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * wspatial * wguide;
+						somme[c] += poids;
+						pixelMoy[c] += poids * (float)value;
+					}
+				}
+			}
+		}
+	}
+
+	for (int c = 0; c < nchan; c++)
+		filtered[c * plane + j * dimx + i] = pixelMoy[c] / somme[c];
+}
+
+__global__ void bilateralKernel(int dimx, int dimy, int nchan, unsigned char *orig, unsigned char *guide, int demisize,
 								float *sweight, float *iweight, float *gweight,
 								float *filtered)
 {
@@ -19,48 +77,100 @@ __global__ void bilateralKernel(int dimx, int dimy, int ncol, unsigned char *ori
 	if (j >= dimy || i >= dimx)
 		return;
 
-	int value, ediff, currentGuide[3], diffGuide;
-	float wguide, somme, poids, pixelMoy, currentIntensity, diff, rdiff;
-	somme = 1e-6f;
-	pixelMoy = 0.0f;
-	currentIntensity = filtered[j * dimx + i];
-	currentGuide[0] = guide[j * dimx + i];
-	if (ncol == 3)
+	// decided per block so the warps do not diverge, only the blocks touching the border ring take the checked loop
+	int x0 = blockIdx.x * blockDim.x, y0 = blockIdx.y * blockDim.y;
+	bool interior = x0 >= demisize && x0 + (int)blockDim.x <= dimx - demisize &&
+					y0 >= demisize && y0 + (int)blockDim.y <= dimy - demisize;
+
+	if (interior)
+		bilateralPixel<false>(i, j, dimx, dimy, nchan, orig, guide, demisize, sweight, iweight, gweight, filtered);
+	else
+		bilateralPixel<true>(i, j, dimx, dimy, nchan, orig, guide, demisize, sweight, iweight, gweight, filtered);
+}
+
+// Fused II + IJ pixel: filters orig guided by guide into filteredIJ and guided by orig into filteredII,
+// each accumulator runs the operations of bilateralPixel, the neighbor loads are shared.
+template <bool Border>
+__device__ void bilateralPixelDual(int i, int j, int dimx, int dimy, int nchan, unsigned char *orig, unsigned char *guide, int demisize,
+								   float *sweight, float *iweight, float *gweight,
+								   float *filteredIJ, float *filteredII)
+{
+	int value, ediff, currentGuide[GBF_MAX_NCHAN], currentOrig[GBF_MAX_NCHAN], diffGuide;
+	float wguide, poids, diff, rdiff;
+	float sommeIJ[GBF_MAX_NCHAN], pixelMoyIJ[GBF_MAX_NCHAN], currentIJ[GBF_MAX_NCHAN];
+	float sommeII[GBF_MAX_NCHAN], pixelMoyII[GBF_MAX_NCHAN], currentII[GBF_MAX_NCHAN];
+	const int plane = dimx * dimy;
+	for (int c = 0; c < nchan; c++)
 	{
-		currentGuide[1] = guide[dimx * dimy + j * dimx + i];
-		currentGuide[2] = guide[2 * dimx * dimy + j * dimx + i];
+		sommeIJ[c] = sommeII[c] = 1e-6f;
+		pixelMoyIJ[c] = pixelMoyII[c] = 0.0f;
+		currentIJ[c] = filteredIJ[c * plane + j * dimx + i];
+		currentII[c] = filteredII[c * plane + j * dimx + i];
+		currentGuide[c] = guide[(j * dimx + i) * nchan + c];
+		currentOrig[c] = orig[(j * dimx + i) * nchan + c];
 	}
-	// don't need to parallize here since only 2x2 max
 	for (int k = -demisize; k <= demisize; k++)
 	{
-		if ((j + k >= 0) && (j + k < dimy))
+		if (!Border || ((j + k >= 0) && (j + k < dimy)))
 		{
 			for (int l = -demisize; l <= demisize; l++)
 			{
-				if ((i + l >= 0) && (i + l < dimx))
+				if (!Border || ((i + l >= 0) && (i + l < dimx)))
 				{
-					value = orig[(j + k) * dimx + i + l];
-					diff = fabs((float)value - currentIntensity);
-					ediff = (int)floor(diff);
-					rdiff = diff - (float)ediff;
-					diffGuide = abs(guide[(j + k) * dimx + i + l] - currentGuide[0]);
-					wguide = gweight[diffGuide];
-					if (ncol == 3)
+					const int pixel = ((j + k) * dimx + i + l) * nchan;
+					const float wspatial = sweight[abs(k)] * sweight[abs(l)];
+					for (int c = 0; c < nchan; c++)
 					{
-						diffGuide = abs(guide[dimx * dimy + (j + k) * dimx + i + l] - currentGuide[1]);
-						wguide *= gweight[diffGuide];
-						diffGuide = abs(guide[2 * dimx * dimy + (j + k) * dimx + i + l] - currentGuide[2]);
-						wguide *= gweight[diffGuide];
+						value = orig[pixel + c];
+
+						diff = fabs((float)value - currentIJ[c]);
+						ediff = (int)floor(diff);
+						rdiff = diff - (float)ediff;
+						diffGuide = abs(guide[pixel + c] - currentGuide[c]);
+						wguide = gweight[diffGuide];
+						poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * wspatial * wguide;
+						sommeIJ[c] += poids;
+						pixelMoyIJ[c] += poids * (float)value;
+
+						diff = fabs((float)value - currentII[c]);
+						ediff = (int)floor(diff);
+						rdiff = diff - (float)ediff;
+						diffGuide = abs(value - currentOrig[c]);
+						wguide = gweight[diffGuide];
+						poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * wspatial * wguide;
+						sommeII[c] += poids;
+						pixelMoyII[c] += poids * (float)value;
 					}
-					poids = ((1.0f - rdiff) * iweight[ediff] + rdiff * iweight[ediff + 1]) * sweight[abs(k)] * sweight[abs(l)] * wguide;
-					somme += poids;
-					pixelMoy += poids * (float)value;
 				}
 			}
 		}
 	}
 
-	filtered[j * dimx + i] = pixelMoy / somme;
+	for (int c = 0; c < nchan; c++)
+	{
+		filteredIJ[c * plane + j * dimx + i] = pixelMoyIJ[c] / sommeIJ[c];
+		filteredII[c * plane + j * dimx + i] = pixelMoyII[c] / sommeII[c];
+	}
+}
+
+__global__ void bilateralKernelDual(int dimx, int dimy, int nchan, unsigned char *orig, unsigned char *guide, int demisize,
+									float *sweight, float *iweight, float *gweight,
+									float *filteredIJ, float *filteredII)
+{
+	int i = threadIdx.x + blockIdx.x * blockDim.x;
+	int j = threadIdx.y + blockIdx.y * blockDim.y;
+
+	if (j >= dimy || i >= dimx)
+		return;
+
+	int x0 = blockIdx.x * blockDim.x, y0 = blockIdx.y * blockDim.y;
+	bool interior = x0 >= demisize && x0 + (int)blockDim.x <= dimx - demisize &&
+					y0 >= demisize && y0 + (int)blockDim.y <= dimy - demisize;
+
+	if (interior)
+		bilateralPixelDual<false>(i, j, dimx, dimy, nchan, orig, guide, demisize, sweight, iweight, gweight, filteredIJ, filteredII);
+	else
+		bilateralPixelDual<true>(i, j, dimx, dimy, nchan, orig, guide, demisize, sweight, iweight, gweight, filteredIJ, filteredII);
 }
 
 class GuidedBilateralFilterGPU
@@ -82,96 +192,52 @@ public:
 		cv::Point(morph_size,
 				  morph_size));
 
-	cv::Mat origimg[3], guideimg[3];
-
-	float *filtered_d;
+	float *filtered_d, *filteredII_d;
 	unsigned char *orig_d;
 	unsigned char *guide_d;
 
-	float *sweight, *iweight, *gweight;
+	float const *sweight, *iweight, *gweight;
 	float *sweight_d, *iweight_d, *gweight_d;
 
-	float *filtered_cpu;
+	float *filtered_cpu, *filteredII_cpu;
 	int size_, size;
 
-	GuidedBilateralFilterGPU(int rows, int cols)
+	// stage and step times of the last frame, see timing.h. a recorded frame synchronizes after every step to time
+	// its kernel. step is the index of the next step of the frame.
+	GuidedBilateralTiming timing;
+	long frame = 0;
+	int step = 0;
+
+	// sized for rows x cols images of nchan interleaved channels
+	GuidedBilateralFilterGPU(int rows, int cols, int nchan = 3)
 	{
-		size_ = rows * cols;
+		size_ = rows * cols * nchan;
 		size = size_ * sizeof(float);
 
 		cudaMalloc((float **)&filtered_d, size);
+		cudaMalloc((float **)&filteredII_d, size);
 		cudaMalloc((unsigned char **)&orig_d, size_);
 		cudaMalloc((unsigned char **)&guide_d, size_);
 
-		sweight = (float *)malloc((hwsize + 1) * sizeof(float));
 		cudaMalloc((float **)&sweight_d, (hwsize + 1) * sizeof(float));
 		cudaMalloc((float **)&iweight_d, 257 * sizeof(float));
 		cudaMalloc((float **)&gweight_d, 256 * sizeof(float));
 
 		filtered_cpu = (float *)malloc(size);
+		filteredII_cpu = (float *)malloc(size);
 	}
 
-	std::map<std::pair<float, float>, float *> iweights;
-	void iweightcalculation(float iscale, float ipower)
+	// dual runs the fused II + IJ kernel, filtered_d guided by guide and filteredII_d guided by orig
+	int GuidedBilateralFilterStep(int dimx, int dimy, int nchan, unsigned char *orig, unsigned char *guide, int demisize,
+								  float sscale, float iscale, float ipower, float gscale, float gpower, bool dual = false)
 	{
-		auto ii = iweights.find(std::make_pair(iscale, ipower));
-		if (ii != iweights.end())
-		{
-			iweight = ii->second;
-		}
-		else
-		{
-			float *new_iweight = (float *)malloc(257 * sizeof(float));
-			/* intensity weight */
-			for (int i = 0; i <= 256; i++)
-			{
-				if (ipower != 1.0f)
-					new_iweight[i] = pow(1.0f + (float)(i * i) / (iscale * iscale), ipower - 1.0f);
-				else
-					new_iweight[i] = 1.0f;
-			}
-			iweights[std::make_pair(iscale, ipower)] = new_iweight;
-			iweight = new_iweight;
-		}
-	}
-
-	std::map<std::pair<float, float>, float *> gweights;
-	void gweightcalculation(float gscale, float gpower)
-	{
-		auto ii = gweights.find(std::make_pair(gscale, gpower));
-		if (ii != gweights.end())
-		{
-			gweight = ii->second;
-		}
-		else
-		{
-			float *new_gweight = (float *)malloc(256 * sizeof(float));
-			/* guide weight */
-			for (int i = 0; i <= 255; i++)
-			{
-				if (gpower != 0.0f)
-					new_gweight[i] = exp(-(pow(1.0f + (float)(i * i) / (gscale * gscale), gpower) - 1.0f) / gpower);
-				else
-					new_gweight[i] = 1.0f / (1.0f + (float)(i * i) / (gscale * gscale));
-			}
-			gweights[std::make_pair(gscale, gpower)] = new_gweight;
-			gweight = new_gweight;
-		}
-	}
+		const double start = timing.active ? GuidedBilateralTiming::Now() : 0.0;
 
-	int GuidedBilateralFilterStep(int dimx, int dimy, int ncol, unsigned char *orig, unsigned char *guide, int demisize,
-								  float sscale, float iscale, float ipower, float gscale, float gpower)
-	{
-		for (int i = 0; i <= demisize; i++)
-		{
-			if (sscale > 0.0f)
-				sweight[i] = exp(-0.5f * (float)(i * i) / (sscale * sscale));
-			else
-				sweight[i] = 1.0f;
-		}
-
-		iweightcalculation(iscale, ipower);
-		gweightcalculation(gscale, gpower);
+		// the tables of the cache shared with the cpu filter, built once per parameter set
+		if (GuidedBilateralSpatialWeights(sscale, demisize, &sweight) == NULL)
+			return (0);
+		if ((iweight = GuidedBilateralIntensityWeights(iscale, ipower)) == NULL || (gweight = GuidedBilateralGuideWeights(gscale, gpower)) == NULL)
+			return (0);
 
 		cudaMemcpy(sweight_d, sweight, (demisize + 1) * sizeof(float), cudaMemcpyHostToDevice);
 		cudaMemcpy(iweight_d, iweight, 257 * sizeof(float), cudaMemcpyHostToDevice);
@@ -179,43 +245,79 @@ public:
 
 		dim3 block(16, 16);
 		dim3 grid((dimx + 15) / 16, (dimy + 15) / 16);
-		bilateralKernel<<<grid, block>>>(dimx, dimy, ncol, orig, guide, demisize,
-										 sweight_d, iweight_d, gweight_d,
-										 filtered_d);
+		if (dual)
+			bilateralKernelDual<<<grid, block>>>(dimx, dimy, nchan, orig, guide, demisize,
+												 sweight_d, iweight_d, gweight_d,
+												 filtered_d, filteredII_d);
+		else
+			bilateralKernel<<<grid, block>>>(dimx, dimy, nchan, orig, guide, demisize,
+											 sweight_d, iweight_d, gweight_d,
+											 filtered_d);
+
+		if (timing.active)
+		{
+			cudaDeviceSynchronize();
+			timing.Step(step, GuidedBilateralTiming::Now() - start);
+		}
+		step++;
 
 		return (1);
 	}
 
-	int GuidedBilateralFilter(int dimx, int dimy, int ncol, unsigned char *orig, unsigned char *guide, int demisize, float sscale, float iscale, float ipower, float gscale, float gpower, unsigned char *result)
+	// orig, guide and result are interleaved, guide may be orig itself.
+	// with resultII the same fused kernel also filters orig guided by itself into resultII.
+	int GuidedBilateralFilter(int dimx, int dimy, int nchan, unsigned char *orig, unsigned char *guide, int demisize, float sscale, float iscale, float ipower, float gscale, float gpower, unsigned char *result, unsigned char *resultII = NULL)
 	{
-		int i, num = 8;
+		const bool dual = resultII != NULL;
+		int i, c, num = 8;
+		const int plane = dimx * dimy;
+
+		if (nchan < 1 || nchan > GBF_MAX_NCHAN || plane * nchan > size_)
+			return (0);
+
+		/* init image, one float plane per channel */
+		{
+			GuidedBilateralStage stage(&timing, "init");
+			for (i = 0; i < plane; i++)
+				for (c = 0; c < nchan; c++)
+					filtered_cpu[c * plane + i] = (float)(orig[i * nchan + c]);
+		}
 
-		/* init image */
-		for (i = 0; i < dimx * dimy; i++)
-			filtered_cpu[i] = (float)(orig[i]);
+		unsigned char *guide_dev = orig_d;
+		{
+			GuidedBilateralStage stage(&timing, "upload");
+			cudaMemcpy(filtered_d, filtered_cpu, plane * nchan * sizeof(float), cudaMemcpyHostToDevice);
+			if (dual)
+				cudaMemcpy(filteredII_d, filtered_cpu, plane * nchan * sizeof(float), cudaMemcpyHostToDevice);
+			cudaMemcpy(orig_d, orig, plane * nchan, cudaMemcpyHostToDevice);
+			if (guide != orig)
+			{
+				cudaMemcpy(guide_d, guide, plane * nchan, cudaMemcpyHostToDevice);
+				guide_dev = guide_d;
+			}
+		}
 
-		cudaMemcpy(filtered_d, filtered_cpu, size, cudaMemcpyHostToDevice);
-		cudaMemcpy(orig_d, orig, (dimx * dimy), cudaMemcpyHostToDevice);
-		cudaMemcpy(guide_d, guide, (dimx * dimy), cudaMemcpyHostToDevice);
+		step = 0;
+		const double filterStart = timing.active ? GuidedBilateralTiming::Now() : 0.0;
 
 		/* GNC */
 		if (ipower <= 1.0f)
 		{
-			if (!GuidedBilateralFilterStep(dimx, dimy, ncol, orig_d, guide_d, demisize, 0.0, iscale, 1.0, gscale * 5.0, gpower))
+			if (!GuidedBilateralFilterStep(dimx, dimy, nchan, orig_d, guide_dev, demisize, 0.0, iscale, 1.0, gscale * 5.0, gpower, dual))
 				return (0);
 			num--;
 		}
 
 		if (ipower <= 0.5f)
 		{
-			if (!GuidedBilateralFilterStep(dimx, dimy, ncol, orig_d, guide_d, demisize, sscale, iscale, 0.5, gscale, gpower))
+			if (!GuidedBilateralFilterStep(dimx, dimy, nchan, orig_d, guide_dev, demisize, sscale, iscale, 0.5, gscale, gpower, dual))
 				return (0);
 			num--;
 		}
 
 		if (ipower <= 0.0f)
 		{
-			if (!GuidedBilateralFilterStep(dimx, dimy, ncol, orig_d, guide_d, demisize, sscale, iscale, 0.0, gscale, gpower))
+			if (!GuidedBilateralFilterStep(dimx, dimy, nchan, orig_d, guide_dev, demisize, sscale, iscale, 0.0, gscale, gpower, dual))
 				return (0);
 			num--;
 		}
@@ -223,14 +325,31 @@ public:
 		/* final */
 		for (i = 0; i < num; i++)
 		{
-			if (!GuidedBilateralFilterStep(dimx, dimy, ncol, orig_d, guide_d, demisize, sscale, iscale, ipower, gscale, gpower))
+			if (!GuidedBilateralFilterStep(dimx, dimy, nchan, orig_d, guide_dev, demisize, sscale, iscale, ipower, gscale, gpower, dual))
 				return (0);
 		}
+		timing.Stage("filter", GuidedBilateralTiming::Now() - filterStart);
 
-		cudaMemcpy(filtered_cpu, filtered_d, size, cudaMemcpyDeviceToHost);
+		{
+			GuidedBilateralStage stage(&timing, "download");
+			cudaMemcpy(filtered_cpu, filtered_d, plane * nchan * sizeof(float), cudaMemcpyDeviceToHost);
+			if (dual)
+				cudaMemcpy(filteredII_cpu, filteredII_d, plane * nchan * sizeof(float), cudaMemcpyDeviceToHost);
+		}
+
+		{
+			GuidedBilateralStage stage(&timing, "convert");
+			for (i = 0; i < plane; i++)
+				for (c = 0; c < nchan; c++)
+					result[i * nchan + c] = (unsigned char)(filtered_cpu[c * plane + i]);
 
-		for (i = 0; i < dimx * dimy; i++)
-			result[i] = (unsigned char)(filtered_cpu[i]);
+			if (dual)
+			{
+				for (i = 0; i < plane; i++)
+					for (c = 0; c < nchan; c++)
+						resultII[i * nchan + c] = (unsigned char)(filteredII_cpu[c * plane + i]);
+			}
+		}
 
 		// cudaError_t error_check = cudaGetLastError();printf("%s\n", cudaGetErrorString(error_check));
 
@@ -239,58 +358,61 @@ public:
 
 	// very slow implementation, to improve
 	// - use cv::cuda functions
-	// - do not split and merge the color channels, change the above functions for the images with stacked color channels
 	cv::Mat Execute(cv::Mat origimg_, cv::Mat guideimg_)
 	{
 		// cv::imshow("orig", origimg_);
 		// cv::imshow("guide", guideimg_);
 
-		cv::split(origimg_, origimg);
-		cv::split(guideimg_, guideimg);
-
-		std::vector<cv::Mat> resultmatIIminusIJ;
-		resultmatIIminusIJ.reserve(3);
+		timing.Begin();
 
-		// bgr color channels loop
-		// TODO: i tried to parallize here, but could not
-		for (int i = 0; i < 3; i++)
+		// the kernel reads the interleaved bgr pixels directly, no split / merge of the color channels
 		{
-			unsigned char *resultIJ = new unsigned char[origimg[i].rows * origimg[i].cols];
-			unsigned char *resultII = new unsigned char[origimg[i].rows * origimg[i].cols];
+			GuidedBilateralStage stage(&timing, "copy");
+			if (!origimg_.isContinuous())
+				origimg_ = origimg_.clone();
+			if (!guideimg_.isContinuous())
+				guideimg_ = guideimg_.clone();
+		}
 
-			GuidedBilateralFilter(origimg[i].rows, origimg[i].cols, origimg[i].channels(), origimg[i].data, guideimg[i].data, hwsize, sscale, iscale, ipower, gscale, gpower, resultIJ);
-			cv::Mat resultmatIJ = cv::Mat(origimg[i].rows, origimg[i].cols, CV_8U, resultIJ);
+		cv::Mat resultmatIJ(origimg_.size(), origimg_.type());
+		cv::Mat resultmatII(origimg_.size(), origimg_.type());
 
-			GuidedBilateralFilter(origimg[i].rows, origimg[i].cols, origimg[i].channels(), origimg[i].data, origimg[i].data, hwsize, sscale, iscale, ipower, gscale, gpower, resultII);
-			cv::Mat resultmatII = cv::Mat(origimg[i].rows, origimg[i].cols, CV_8U, resultII);
-			// cv::imwrite("../output_images/result_gpu_IJ.png", resultmatIJ);
-			// cv::imwrite("../output_images/result_gpu_II.png", resultmatII);
+		// IJ guided by the other image and II guided by orig itself, in one fused kernel per step
+		GuidedBilateralFilter(origimg_.cols, origimg_.rows, origimg_.channels(), origimg_.data, guideimg_.data, hwsize, sscale, iscale, ipower, gscale, gpower, resultmatIJ.data, resultmatII.data);
+		// cv::imwrite("../output_images/result_gpu_IJ.png", resultmatIJ);
+		// cv::imwrite("../output_images/result_gpu_II.png", resultmatII);
 
-			cv::Mat resultmatIIminusIJ_channel;
-			cv::absdiff(resultmatII, resultmatIJ, resultmatIIminusIJ_channel);
+		// absdiff, threshold and opening work channel by channel
+		cv::Mat resultmatIIminusIJ;
+		{
+			GuidedBilateralStage stage(&timing, "absdiff");
+			cv::absdiff(resultmatII, resultmatIJ, resultmatIIminusIJ);
+		}
 
-			cv::threshold(resultmatIIminusIJ_channel, resultmatIIminusIJ_channel, threshold, 255, 1);
+		{
+			GuidedBilateralStage stage(&timing, "threshold");
+			cv::threshold(resultmatIIminusIJ, resultmatIIminusIJ, threshold, 255, 1);
+		}
 
-			morphologyEx(resultmatIIminusIJ_channel, resultmatIIminusIJ_channel,
+		{
+			GuidedBilateralStage stage(&timing, "opening");
+			morphologyEx(resultmatIIminusIJ, resultmatIIminusIJ,
 						 cv::MORPH_OPEN, element,
 						 cv::Point(-1, -1), 2);
-
-			resultmatIIminusIJ.emplace_back(resultmatIIminusIJ_channel);
-
-			// cv::imshow("resIJ channel:" + std::to_string(i), resultmatIJ);
-			// cv::imshow("resII channel:" + std::to_string(i), resultmatII);
-			// cv::imshow("distance channel:" + std::to_string(i), resultmatIIminusIJ_channel);
 		}
 
-		cv::Mat mergedresultmatIIminusIJ;
-		merge(resultmatIIminusIJ, mergedresultmatIIminusIJ);
+		// cv::imshow("resIJ", resultmatIJ);
+		// cv::imshow("resII", resultmatII);
+		// cv::imshow("distance", resultmatIIminusIJ);
 
-		return mergedresultmatIIminusIJ;
+		timing.End("gpu", frame++);
+		return resultmatIIminusIJ;
 	}
 
 	~GuidedBilateralFilterGPU()
 	{
 		cudaFree(filtered_d);
+		cudaFree(filteredII_d);
 		cudaFree(orig_d);
 		cudaFree(guide_d);
 
@@ -299,10 +421,7 @@ public:
 		cudaFree(gweight_d);
 
 		free(filtered_cpu);
-
-		for(auto ii : iweights) free(ii.second);
-		for(auto ii : gweights) free(ii.second);
-		free(sweight);
+		free(filteredII_cpu);
 	}
 };
 
@@ -313,7 +432,9 @@ int main()
 	cv::Mat guideimg_ = cv::imread("../input_images/makale_0.png", cv::IMREAD_COLOR);
 	guideimg_.convertTo(guideimg_, CV_8U); // just for safety
 
-	GuidedBilateralFilterGPU gbFilter(origimg_.rows, origimg_.cols);
+	GuidedBilateralFilterGPU gbFilter(origimg_.rows, origimg_.cols, origimg_.channels());
+	// GBF_TIMING_JSON=timing.jsonl writes the stage times of every frame, with a -DGBF_TIMING=ON build
+	GuidedBilateralTimingFromEnv();
 
 	int n_iter = 1;
 	auto start = std::chrono::steady_clock::now();
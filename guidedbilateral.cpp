@@ -0,0 +1,113 @@
+#include "guidedbilateral.h"
+#include "cpu_filter.h"
+
+#include <stdlib.h>
+#include <new>
+
+struct GuidedBilateralContext
+{
+	GuidedBilateralTables tables;
+	// float planes of the filter, and resultII when the caller has no use for it
+	float *scratch;
+	size_t scratchSize;
+	unsigned char *spare;
+	size_t spareSize;
+};
+
+int GuidedBilateralApiVersion(void)
+{
+	return GUIDEDBILATERAL_API_VERSION;
+}
+
+void GuidedBilateralDefaultParams(GuidedBilateralParams *params)
+{
+	params->demisize = 2;
+	params->sscale = 1.5f;
+	params->iscale = 10.0f;
+	params->ipower = 0.0f;
+	params->gscale = 10.0f;
+	params->gpower = 1.0f;
+}
+
+GuidedBilateralContext *GuidedBilateralCreate(const GuidedBilateralParams *params)
+{
+	GuidedBilateralParams defaults;
+
+	if (params == NULL)
+	{
+		GuidedBilateralDefaultParams(&defaults);
+		params = &defaults;
+	}
+	if (params->demisize < 0 || params->iscale <= 0.0f || params->gscale <= 0.0f)
+		return NULL;
+
+	GuidedBilateralContext *context = new (std::nothrow) GuidedBilateralContext;
+	if (context == NULL)
+		return NULL;
+	if (!GuidedBilateralBuildTables(params->demisize, params->sscale, params->iscale, params->ipower, params->gscale, params->gpower, &context->tables))
+	{
+		delete context;
+		return NULL;
+	}
+	context->scratch = NULL;
+	context->scratchSize = 0;
+	context->spare = NULL;
+	context->spareSize = 0;
+
+	return context;
+}
+
+void GuidedBilateralDestroy(GuidedBilateralContext *context)
+{
+	if (context == NULL)
+		return;
+	delete[] context->scratch;
+	delete[] context->spare;
+	GuidedBilateralFreeTables(&context->tables);
+	delete context;
+}
+
+int GuidedBilateralRun(GuidedBilateralContext *context, int width, int height, int nchan,
+					   const unsigned char *orig, int origStride, const unsigned char *guide, int guideStride,
+					   unsigned char *resultIJ, int resultIJStride, unsigned char *resultII, int resultIIStride)
+{
+	if (context == NULL || orig == NULL || guide == NULL || resultIJ == NULL)
+		return (0);
+	if (width <= 0 || height <= 0 || nchan < 1 || nchan > GBF_MAX_NCHAN)
+		return (0);
+
+	// a row must hold its pixels, rows may go upwards
+	const int row = width * nchan;
+	if (abs(origStride) < row || abs(guideStride) < row || abs(resultIJStride) < row)
+		return (0);
+
+	const size_t planes = 2 * (size_t)nchan * width * height;
+	if (planes > context->scratchSize)
+	{
+		delete[] context->scratch;
+		context->scratchSize = 0;
+		if ((context->scratch = new (std::nothrow) float[planes]) == NULL)
+			return (0);
+		context->scratchSize = planes;
+	}
+
+	if (resultII == NULL)
+	{
+		const size_t bytes = (size_t)row * height;
+		if (bytes > context->spareSize)
+		{
+			delete[] context->spare;
+			context->spareSize = 0;
+			if ((context->spare = new (std::nothrow) unsigned char[bytes]) == NULL)
+				return (0);
+			context->spareSize = bytes;
+		}
+		resultII = context->spare;
+		resultIIStride = row;
+	}
+	else if (abs(resultIIStride) < row)
+		return (0);
+
+	return GuidedBilateralFilterDualScratch(width, height, nchan, orig, origStride, guide, guideStride, &context->tables, context->scratch,
+											resultIJ, resultIJStride, resultII, resultIIStride);
+}
@@ -0,0 +1,61 @@
+#ifndef GUIDEDBILATERAL_H
+#define GUIDEDBILATERAL_H
+
+#include <stddef.h>
+
+// C api of libguidedbilateral, the fused filter of the cpu pipeline without OpenCV: orig filtered guided by guide
+// into resultIJ and guided by itself into resultII, the two images GuidedBilateralFilterCPU compares.
+// Images are 8 bit with nchan interleaved channels, pixel (x, y) at data + y * stride + x * nchan. The stride is the
+// byte distance between two rows, width * nchan for a contiguous image: a cv::Mat roi passes its data and step, a
+// numpy view its data pointer and strides[0]. The inputs are read in place, the results written in place.
+//
+// The symbols below are the only ones exported by the shared library. A context holds the weight tables and the
+// float planes of the filter, it is reused frame after frame without allocation while the size does not grow. A
+// context is used by one thread at a time, the filter itself runs on every core through OpenMP.
+
+#if defined(_WIN32) && defined(GUIDEDBILATERAL_BUILD)
+#define GUIDEDBILATERAL_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define GUIDEDBILATERAL_API __attribute__((visibility("default")))
+#else
+#define GUIDEDBILATERAL_API
+#endif
+
+// bumped when a function or a struct below changes
+#define GUIDEDBILATERAL_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	typedef struct GuidedBilateralParams
+	{
+		int demisize;
+		float sscale, iscale, ipower, gscale, gpower;
+	} GuidedBilateralParams;
+
+	typedef struct GuidedBilateralContext GuidedBilateralContext;
+
+	// GUIDEDBILATERAL_API_VERSION of the library, to check against the header
+	GUIDEDBILATERAL_API int GuidedBilateralApiVersion(void);
+
+	// parameters of the cpu and gpu pipelines: demisize 2, sscale 1.5, iscale 10, ipower 0, gscale 10, gpower 1
+	GUIDEDBILATERAL_API void GuidedBilateralDefaultParams(GuidedBilateralParams *params);
+
+	// NULL params for the defaults. returns NULL for invalid parameters.
+	GUIDEDBILATERAL_API GuidedBilateralContext *GuidedBilateralCreate(const GuidedBilateralParams *params);
+	GUIDEDBILATERAL_API void GuidedBilateralDestroy(GuidedBilateralContext *context);
+
+	// Filters a width x height pair of nchan channels, 1 to 4. resultII may be NULL when only the guided result is
+	// needed, it is then written to a buffer of the context. The results must not overlap the inputs.
+	// returns 1, 0 for invalid arguments or a failed allocation.
+	GUIDEDBILATERAL_API int GuidedBilateralRun(GuidedBilateralContext *context, int width, int height, int nchan,
+											   const unsigned char *orig, int origStride, const unsigned char *guide, int guideStride,
+											   unsigned char *resultIJ, int resultIJStride, unsigned char *resultII, int resultIIStride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
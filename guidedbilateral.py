@@ -0,0 +1,196 @@
+"""Zero-copy binding of libguidedbilateral, see guidedbilateral.h.
+
+Takes any object exporting the buffer protocol with 8 bit pixels: numpy arrays from cv2.imread and their slices,
+memoryviews, bytearrays reshaped with memoryview.cast. The images are passed to the library by pointer and row
+stride, a roi or a flipped view is filtered in place without a copy. The pixels of a row must be contiguous:
+shape (height, width) or (height, width, nchan) with strides (any, nchan, 1).
+
+    import cv2, guidedbilateral
+    orig = cv2.imread("input_images/makale_1.png")
+    guide = cv2.imread("input_images/makale_0.png")
+    with guidedbilateral.Filter() as f:
+        ij, ii = f.run(orig[100:400, 50:300], guide[100:400, 50:300])
+
+The library is looked up next to this file, then in the build directory, then by the loader, GUIDEDBILATERAL_LIBRARY
+overrides the path.
+"""
+
+import ctypes
+import os
+
+API_VERSION = 1
+
+# Py_buffer request flags of Python's buffer protocol
+_PyBUF_WRITABLE = 0x0001
+_PyBUF_FORMAT = 0x0004
+_PyBUF_STRIDES = 0x0010 | 0x0008
+
+
+class Params(ctypes.Structure):
+    _fields_ = [("demisize", ctypes.c_int),
+                ("sscale", ctypes.c_float), ("iscale", ctypes.c_float), ("ipower", ctypes.c_float),
+                ("gscale", ctypes.c_float), ("gpower", ctypes.c_float)]
+
+
+class _Py_buffer(ctypes.Structure):
+    _fields_ = [("buf", ctypes.c_void_p), ("obj", ctypes.c_void_p), ("len", ctypes.c_ssize_t),
+                ("itemsize", ctypes.c_ssize_t), ("readonly", ctypes.c_int), ("ndim", ctypes.c_int),
+                ("format", ctypes.c_char_p), ("shape", ctypes.POINTER(ctypes.c_ssize_t)),
+                ("strides", ctypes.POINTER(ctypes.c_ssize_t)), ("suboffsets", ctypes.POINTER(ctypes.c_ssize_t)),
+                ("internal", ctypes.c_void_p)]
+
+
+_GetBuffer = ctypes.pythonapi.PyObject_GetBuffer
+_GetBuffer.argtypes = [ctypes.py_object, ctypes.POINTER(_Py_buffer), ctypes.c_int]
+_GetBuffer.restype = ctypes.c_int
+_ReleaseBuffer = ctypes.pythonapi.PyBuffer_Release
+_ReleaseBuffer.argtypes = [ctypes.POINTER(_Py_buffer)]
+_ReleaseBuffer.restype = None
+
+
+def _load():
+    here = os.path.dirname(os.path.abspath(__file__))
+    names = ["libguidedbilateral.so", "libguidedbilateral.dylib", "guidedbilateral.dll"]
+    paths = [os.environ.get("GUIDEDBILATERAL_LIBRARY")]
+    paths += [os.path.join(d, n) for d in (here, os.path.join(here, "build")) for n in names]
+    paths += names
+    for path in paths:
+        if path and (os.path.exists(path) or os.path.basename(path) == path):
+            try:
+                lib = ctypes.CDLL(path)
+                break
+            except OSError:
+                continue
+    else:
+        raise OSError("libguidedbilateral not found, build it or set GUIDEDBILATERAL_LIBRARY")
+
+    lib.GuidedBilateralApiVersion.argtypes = []
+    lib.GuidedBilateralApiVersion.restype = ctypes.c_int
+    if lib.GuidedBilateralApiVersion() != API_VERSION:
+        raise OSError("libguidedbilateral api version %d, expected %d" % (lib.GuidedBilateralApiVersion(), API_VERSION))
+    lib.GuidedBilateralDefaultParams.argtypes = [ctypes.POINTER(Params)]
+    lib.GuidedBilateralDefaultParams.restype = None
+    lib.GuidedBilateralCreate.argtypes = [ctypes.POINTER(Params)]
+    lib.GuidedBilateralCreate.restype = ctypes.c_void_p
+    lib.GuidedBilateralDestroy.argtypes = [ctypes.c_void_p]
+    lib.GuidedBilateralDestroy.restype = None
+    lib.GuidedBilateralRun.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_int,
+                                       ctypes.c_void_p, ctypes.c_int, ctypes.c_void_p, ctypes.c_int,
+                                       ctypes.c_void_p, ctypes.c_int, ctypes.c_void_p, ctypes.c_int]
+    lib.GuidedBilateralRun.restype = ctypes.c_int
+    return lib
+
+
+_lib = None
+
+
+def _library():
+    global _lib
+    if _lib is None:
+        _lib = _load()
+    return _lib
+
+
+class _Image(object):
+    """The buffer of an 8 bit image held for the duration of a call: pointer, height, width, nchan, row stride."""
+
+    def __init__(self, obj, writable):
+        self.view = _Py_buffer()
+        flags = _PyBUF_STRIDES | _PyBUF_FORMAT | (_PyBUF_WRITABLE if writable else 0)
+        if _GetBuffer(obj, ctypes.byref(self.view), flags) != 0:
+            raise TypeError("a %sbuffer of 8 bit pixels is expected" % ("writable " if writable else ""))
+        v = self.view
+        try:
+            fmt = v.format.decode() if v.format else "B"
+            if v.itemsize != 1 or fmt.lstrip("@=<>!") not in ("B", "b", "c"):
+                raise TypeError("8 bit pixels are expected, got format %r" % fmt)
+            if v.ndim == 2:
+                self.height, self.width, self.nchan = v.shape[0], v.shape[1], 1
+            elif v.ndim == 3:
+                self.height, self.width, self.nchan = v.shape[0], v.shape[1], v.shape[2]
+            else:
+                raise ValueError("shape (height, width) or (height, width, nchan) is expected")
+            # the pixels of a row contiguous, any distance between the rows
+            if (v.ndim == 3 and v.strides[2] != 1) or v.strides[1] != self.nchan:
+                raise ValueError("the pixels of a row must be contiguous and interleaved")
+            self.pointer = v.buf
+            self.stride = v.strides[0]
+        except Exception:
+            _ReleaseBuffer(ctypes.byref(self.view))
+            raise
+
+    def release(self):
+        _ReleaseBuffer(ctypes.byref(self.view))
+
+
+def _empty(height, width, nchan):
+    shape = (height, width, nchan) if nchan > 1 else (height, width)
+    return memoryview(bytearray(height * width * nchan)).cast("B", shape)
+
+
+class Filter(object):
+    """A context of the library: the tables of the parameters and the planes of the filter, reused by run."""
+
+    def __init__(self, demisize=2, sscale=1.5, iscale=10.0, ipower=0.0, gscale=10.0, gpower=1.0):
+        lib = _library()
+        params = Params(demisize, sscale, iscale, ipower, gscale, gpower)
+        self._context = lib.GuidedBilateralCreate(ctypes.byref(params))
+        if not self._context:
+            raise ValueError("invalid parameters")
+
+    def close(self):
+        if self._context:
+            _library().GuidedBilateralDestroy(self._context)
+            self._context = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def run(self, orig, guide, resultIJ=None, resultII=None, both=True):
+        """Filters orig guided by guide into resultIJ and guided by itself into resultII, allocated when None.
+        Returns (resultIJ, resultII), or resultIJ alone when both is False and resultII None. The allocated
+        results are memoryviews, numpy.asarray wraps them without a copy."""
+        images = []
+        try:
+            o = _Image(orig, False)
+            images.append(o)
+            g = _Image(guide, False)
+            images.append(g)
+            if (g.height, g.width, g.nchan) != (o.height, o.width, o.nchan):
+                raise ValueError("orig and guide must have the same shape")
+            if resultIJ is None:
+                resultIJ = _empty(o.height, o.width, o.nchan)
+            if resultII is None and both:
+                resultII = _empty(o.height, o.width, o.nchan)
+            rij = _Image(resultIJ, True)
+            images.append(rij)
+            rii = None
+            if resultII is not None:
+                rii = _Image(resultII, True)
+                images.append(rii)
+            for r in (rij, rii):
+                if r is not None and (r.height, r.width, r.nchan) != (o.height, o.width, o.nchan):
+                    raise ValueError("the results must have the shape of orig")
+
+            ok = _library().GuidedBilateralRun(self._context, o.width, o.height, o.nchan, o.pointer, o.stride,
+                                               g.pointer, g.stride, rij.pointer, rij.stride,
+                                               rii.pointer if rii else None, rii.stride if rii else 0)
+            if not ok:
+                raise RuntimeError("GuidedBilateralRun failed")
+        finally:
+            for image in images:
+                image.release()
+
+        return (resultIJ, resultII) if resultII is not None or both else resultIJ
+
+
+def run(orig, guide, **params):
+    """One pair with a context of its own, see Filter.run"""
+    with Filter(**params) as f:
+        return f.run(orig, guide)
@@ -0,0 +1,129 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+
+// Opt-in stage timing of the cpu and gpu pipelines, one json line per frame, in milliseconds:
+// {"pipeline":"cpu","frame":3,"total":412.9,"stages":{"prepare":0.1,"filter":410.2,"opening":2.6},"steps":[61.2,...]}
+// Compiled in with GBF_TIMING (cmake -DGBF_TIMING=ON), then recorded while an output is set, the check being one
+// relaxed atomic load per frame. Without GBF_TIMING the stages compile to nothing.
+#define GBF_TIMING_MAX_STAGES 16
+#define GBF_TIMING_MAX_STEPS 8
+
+static inline std::atomic<FILE *> &GuidedBilateralTimingFile()
+{
+	static std::atomic<FILE *> file(NULL);
+	return file;
+}
+
+// file receives the json lines, NULL stops the recording
+static inline void GuidedBilateralTimingOutput(FILE *file)
+{
+	GuidedBilateralTimingFile().store(file, std::memory_order_relaxed);
+}
+
+// appends to the file named by GBF_TIMING_JSON, "-" for stdout, when it is set
+static inline void GuidedBilateralTimingFromEnv()
+{
+	const char *name = getenv("GBF_TIMING_JSON");
+	if (name != NULL)
+		GuidedBilateralTimingOutput(name[0] == '-' && name[1] == 0 ? stdout : fopen(name, "a"));
+}
+
+struct GuidedBilateralTiming
+{
+	const char *names[GBF_TIMING_MAX_STAGES];
+	double stages[GBF_TIMING_MAX_STAGES], steps[GBF_TIMING_MAX_STEPS];
+	double start;
+	int nstages, nsteps;
+	bool active = false;
+
+	static double Now()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// starts a frame, recorded if an output is set
+	void Begin()
+	{
+#ifdef GBF_TIMING
+		active = GuidedBilateralTimingFile().load(std::memory_order_relaxed) != NULL;
+#endif
+		nstages = nsteps = 0;
+		start = active ? Now() : 0.0;
+	}
+
+	// adds ms to the stage name, a stage recorded twice in a frame sums its times
+	void Stage(const char *name, double ms)
+	{
+		if (!active)
+			return;
+		int s = 0;
+		while (s < nstages && names[s] != name)
+			s++;
+		if (s == nstages)
+		{
+			if (nstages == GBF_TIMING_MAX_STAGES)
+				return;
+			names[nstages] = name;
+			stages[nstages++] = 0.0;
+		}
+		stages[s] += ms;
+	}
+
+	// adds ms to the step s of the filter
+	void Step(int s, double ms)
+	{
+		if (!active || s < 0 || s >= GBF_TIMING_MAX_STEPS)
+			return;
+		for (; nsteps <= s; nsteps++)
+			steps[nsteps] = 0.0;
+		steps[s] += ms;
+	}
+
+	// writes the line of the frame in one call, the lines of concurrent engines do not mix
+	void End(const char *pipeline, long frame)
+	{
+		FILE *file = GuidedBilateralTimingFile().load(std::memory_order_relaxed);
+		if (!active || file == NULL)
+			return;
+
+		char line[2048];
+		int n = snprintf(line, sizeof(line), "{\"pipeline\":\"%s\",\"frame\":%ld,\"total\":%.3f,\"stages\":{", pipeline, frame, Now() - start);
+		for (int s = 0; s < nstages && n < (int)sizeof(line); s++)
+			n += snprintf(line + n, sizeof(line) - n, "%s\"%s\":%.3f", s ? "," : "", names[s], stages[s]);
+		if (n < (int)sizeof(line))
+			n += snprintf(line + n, sizeof(line) - n, "},\"steps\":[");
+		for (int s = 0; s < nsteps && n < (int)sizeof(line); s++)
+			n += snprintf(line + n, sizeof(line) - n, "%s%.3f", s ? "," : "", steps[s]);
+		if (n < (int)sizeof(line))
+			snprintf(line + n, sizeof(line) - n, "]}\n");
+		fputs(line, file);
+		fflush(file);
+	}
+};
+
+// records the time of its scope as a stage
+struct GuidedBilateralStage
+{
+#ifdef GBF_TIMING
+	GuidedBilateralTiming *timing;
+	const char *name;
+	double start;
+
+	GuidedBilateralStage(GuidedBilateralTiming *timing, const char *name)
+		: timing(timing), name(name), start(timing->active ? GuidedBilateralTiming::Now() : 0.0) {}
+	~GuidedBilateralStage()
+	{
+		if (timing->active)
+			timing->Stage(name, GuidedBilateralTiming::Now() - start);
+	}
+#else
+	GuidedBilateralStage(GuidedBilateralTiming *, const char *) {}
+#endif
+};
+
+#endif